@@ -29,91 +29,261 @@
 #include <iostream>
 #include <new>
 #include <cstring>
+#include <cstdint>
+#include <type_traits>
+#include <vector>
 
 
+/**
+ * Bit vector stored in 64-bit words.
+ *
+ * Searching for the next/previous set bit processes a whole word at a time
+ * using count-trailing/leading-zeros instructions. Optionally, after all bits
+ * are set, rank/select support may be built with buildRankSelect(), which makes
+ * rank1(), select1() and long-distance next() lookups constant time.
+ */
 template<typename Tnum>
 class BitVector {
 public:
-    explicit BitVector(Tnum size) : numBits(size) {
-        data = new unsigned char[(numBits >> 3) + 1]();
+    explicit BitVector(Tnum size) : numBits(size), numWords((size >> 6) + 1), capacityWords(numWords) {
+        data = new uint64_t[numWords]();
     }
 
+    BitVector(const BitVector &) = delete;
+    BitVector &operator=(const BitVector &) = delete;
+
     virtual ~BitVector() {
         delete[] data;
     }
 
     void clear() {
-        memset(data, 0, ((numBits >> 3) + 1) * sizeof(unsigned char));
+        memset(data, 0, numWords * sizeof(uint64_t));
+        blockRanks.clear();
+        selectSamples.clear();
+    }
+
+    /** Makes room for size bits (and their rank/select directories), so that reset() up to size does not allocate. */
+    void reserve(Tnum size) {
+        Tnum words = (size >> 6) + 1;
+
+        if (words > capacityWords) {
+            uint64_t *newData = new uint64_t[words]();
+
+            memcpy(newData, data, numWords * sizeof(uint64_t));
+            delete[] data;
+            data = newData;
+            capacityWords = words;
+        }
+
+        blockRanks.reserve((words + BlockWords - 1) / BlockWords + 1);
+        selectSamples.reserve(size / SelectSample + 2);
+    }
+
+    /** Changes the size of the vector to size bits, all of them cleared. The memory is reused if possible. */
+    void reset(Tnum size) {
+        reserve(size);
+        numBits = size;
+        numWords = (size >> 6) + 1;
+        clear();
     }
 
     inline Tnum size() const {
         return numBits;
     }
 
+    /** Returns the number of bytes allocated for the bits and the rank/select directories. */
+    inline size_t memoryUsage() const {
+        return capacityWords * sizeof(uint64_t) + blockRanks.capacity() * sizeof(Tnum) + selectSamples.capacity() * sizeof(Tnum);
+    }
+
+    /** Returns the bit at position pos, or false if pos is out of range. */
     inline bool get(Tnum pos) const {
-        return !(pos < 0 || pos >= numBits) && (data[pos >> 3] >> (pos & 7)) & 1;
+        return (UTnum) pos < (UTnum) numBits && (*this)[pos];
+    }
+
+    /** Returns the bit at position pos without bounds checking. */
+    inline bool operator[](Tnum pos) const {
+        return (data[pos >> 6] >> (pos & 63)) & 1;
     }
 
+    /** Sets the bit at position pos to val, positions out of range are ignored. */
     inline void set(Tnum pos, bool val) {
-        if (pos < 0 || pos >= numBits)
-            return;
+        if ((UTnum) pos < (UTnum) numBits)
+            setUnchecked(pos, val);
+    }
 
-        if(val) {
-            data[pos >> 3] |= (unsigned char)(1U << (pos & 7));
+    /** Sets the bit at position pos to val without bounds checking. */
+    inline void setUnchecked(Tnum pos, bool val) {
+        if (val) {
+            data[pos >> 6] |= (uint64_t(1) << (pos & 63));
         }
         else {
-            data[pos >> 3] &= (unsigned char)(~(1U << (pos & 7)));
+            data[pos >> 6] &= ~(uint64_t(1) << (pos & 63));
         }
     }
 
-    Tnum next(Tnum pos) const {
-        Tnum j;
-        unsigned int c;
+    /** Returns the w-th 64-bit word (bits 64w..64w+63, the lowest position in the lowest bit), or 0 beyond the vector. */
+    inline uint64_t word(Tnum w) const {
+        return (w < numWords) ? data[w] : 0;
+    }
+
+    /** Hints the processor to load the word containing the bit at position pos into the cache. */
+    inline void prefetch(Tnum pos) const {
+        __builtin_prefetch(data + (pos >> 6));
+    }
+
+    /** Replaces the w-th 64-bit word without bounds checking. */
+    inline void setWord(Tnum w, uint64_t bits) {
+        data[w] = bits;
+    }
 
+    /** Returns the position of the first set bit after pos, or size() if there is none. */
+    Tnum next(Tnum pos) const {
         pos += 1;
-        j = pos >> 3;
-        c = data[j] >> (pos & 7);
 
-        if(c == 0) {
-            pos += 8 - (pos & 7);
-            j += 1;
+        if (pos >= numBits)
+            return numBits;
+
+        Tnum j = pos >> 6;
+        uint64_t c = data[j] & (~uint64_t(0) << (pos & 63));
+
+        // Scan a few words, long gaps are skipped with rank/select if available
+        for (Tnum scanned = 0; c == 0; ++scanned) {
+            if (scanned == BlockWords && !blockRanks.empty()) {
+                Tnum r = rank1(pos);
+                return (r < numOnes) ? select1(r) : numBits;
+            }
 
-            for(; (c = data[j]) == 0; ++j, pos += 8) { }
+            if (++j >= numWords)
+                return numBits;
+
+            c = data[j];
         }
 
-        for(; (c & 1) == 0; ++pos, c >>= 1) { }
+        Tnum res = (j << 6) + __builtin_ctzll(c);
 
-        return pos;
+        return (res < numBits) ? res : numBits;
     }
 
+    /** Returns the position of the last set bit before pos, or -1 if there is none. */
     Tnum prev(Tnum pos) const {
-        Tnum j;
-        unsigned int c;
-
         pos -= 1;
 
-        if(0 <= pos) {
-            j = pos >> 3;
-            c = (data[j] << (7 - (pos & 7))) & 0xff;
+        if (pos < 0)
+            return -1;
+
+        Tnum j = pos >> 6;
+        uint64_t c = data[j] & (~uint64_t(0) >> (63 - (pos & 63)));
 
-            if(c == 0) {
-                pos -= (pos & 7) + 1;
-                j -= 1;
+        for (Tnum scanned = 0; c == 0; ++scanned) {
+            if (scanned == BlockWords && !blockRanks.empty()) {
+                Tnum r = rank1(pos);
+                return (r > 0) ? select1(r - 1) : -1;
+            }
+
+            if (--j < 0)
+                return -1;
+
+            c = data[j];
+        }
+
+        return (j << 6) + 63 - __builtin_clzll(c);
+    }
+
+    //-------------------------------------------------------------------------
+    // Rank/select support
+    //-------------------------------------------------------------------------
+
+    /** Builds the rank/select directories. Has to be called again after the bits are modified. */
+    void buildRankSelect() {
+        Tnum numBlocks = (numWords + BlockWords - 1) / BlockWords;
 
-                for(; (0 <= j) && ((c = data[j]) == 0); --j, pos -= 8) { }
+        blockRanks.assign(numBlocks + 1, 0);
+        selectSamples.clear();
 
-                if(c == 0) { c = 128; }
+        Tnum total = 0;
+
+        for (Tnum b = 0; b < numBlocks; ++b) {
+            blockRanks[b] = total;
+
+            for (Tnum w = b * BlockWords; w < numWords && w < (b + 1) * BlockWords; ++w) {
+                uint64_t c = data[w];
+
+                // Record the block containing every SelectSample-th set bit
+                for (Tnum k = (total + SelectSample - 1) / SelectSample * SelectSample,
+                          cnt = __builtin_popcountll(c); k < total + cnt; k += SelectSample) {
+                    selectSamples.push_back(b);
+                }
+
+                total += __builtin_popcountll(c);
             }
+        }
+
+        blockRanks[numBlocks] = total;
+        selectSamples.push_back(numBlocks);
+        numOnes = total;
+    }
 
-            for(; (c & 128) == 0; --pos, c <<= 1) { }
+    /** Returns the number of set bits at positions [0, pos). Requires buildRankSelect(). */
+    Tnum rank1(Tnum pos) const {
+        Tnum w = pos >> 6;
+        Tnum r = blockRanks[w / BlockWords];
+
+        for (Tnum i = w - w % BlockWords; i < w; ++i)
+            r += __builtin_popcountll(data[i]);
+
+        if (pos & 63)
+            r += __builtin_popcountll(data[w] << (64 - (pos & 63)));
+
+        return r;
+    }
+
+    /** Returns the position of the k-th (counting from 0) set bit. Requires buildRankSelect(). */
+    Tnum select1(Tnum k) const {
+        // Locate the block using select samples and then the block directory
+        Tnum lo = selectSamples[k / SelectSample];
+        Tnum hi = selectSamples[k / SelectSample + 1];
+
+        while (lo < hi) {
+            Tnum mid = lo + (hi - lo + 1) / 2;
+
+            if (blockRanks[mid] <= k)
+                lo = mid;
+            else
+                hi = mid - 1;
         }
 
-        return pos;
+        k -= blockRanks[lo];
+
+        Tnum w = lo * BlockWords;
+        Tnum cnt;
+
+        for (; (cnt = __builtin_popcountll(data[w])) <= k; ++w)
+            k -= cnt;
+
+        // Select within a single word
+        uint64_t c = data[w];
+
+        for (; k > 0; --k)
+            c &= c - 1;
+
+        return (w << 6) + __builtin_ctzll(c);
     }
 
 private:
+    using UTnum = typename std::make_unsigned<Tnum>::type;
+
+    static constexpr Tnum BlockWords = 8;
+    static constexpr Tnum SelectSample = 512;
+
     Tnum numBits;
-    unsigned char *data;
+    Tnum numWords;
+    Tnum capacityWords;
+    uint64_t *data;
+
+    Tnum numOnes = 0;
+    std::vector<Tnum> blockRanks;
+    std::vector<Tnum> selectSamples;
 };
 
 
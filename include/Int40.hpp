@@ -0,0 +1,74 @@
+#ifndef _INT40_HPP_
+#define _INT40_HPP_
+
+/*
+ * Packed 40-bit signed integer.
+ *
+ * (c) 2023 Marcin Piątkowski, marcin.piatkowski(at)mat.umk.pl
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include <cstdint>
+#include <cstring>
+
+
+/**
+ * A signed integer stored in 5 bytes (range [-2^39, 2^39)) used as a compact element type of suffix arrays.
+ *
+ * Arrays of Int40 take 5n bytes instead of 8n bytes for 64-bit integers, so suffix arrays of inputs
+ * larger than 2 GiB need 37.5% less memory. The value is converted to and from long implicitly,
+ * hence Int40 * may be used wherever a pointer to the suffix array (Tsa *) is expected, while all
+ * computations are done on long (Tnum = long).
+ */
+class Int40 {
+public:
+    Int40() = default;
+
+    Int40(long value) {
+        uint32_t low = (uint32_t) value;
+
+        memcpy(bytes, &low, sizeof(low));
+        bytes[4] = (unsigned char) (value >> 32);
+    }
+
+    operator long() const {
+        uint32_t low;
+
+        memcpy(&low, bytes, sizeof(low));
+
+        return (long) (signed char) bytes[4] * (1L << 32) + low;
+    }
+
+    static constexpr long min() {
+        return -(1L << 39);
+    }
+
+    static constexpr long max() {
+        return (1L << 39) - 1;
+    }
+
+private:
+    unsigned char bytes[5];
+};
+
+static_assert(sizeof(Int40) == 5, "Int40 has to be packed into 5 bytes");
+
+
+#endif //_INT40_HPP_
@@ -0,0 +1,158 @@
+#ifndef _MAPPED_FILE_HPP_
+#define _MAPPED_FILE_HPP_
+
+/**
+ * Memory-mapped file implementation.
+ *
+ * (c) 2023 Marcin Piątkowski, marcin.piatkowski(at)mat.umk.pl
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include <cstddef>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+
+/**
+ * A file mapped into memory, either read-only (an existing file) or read-write (a newly created file).
+ * Empty files are supported, in which case data() returns nullptr.
+ */
+class MappedFile {
+public:
+    MappedFile() = default;
+
+    MappedFile(const MappedFile &) = delete;
+    MappedFile &operator=(const MappedFile &) = delete;
+
+    virtual ~MappedFile() {
+        close();
+    }
+
+    /** Maps an existing file read-only. @return true on success */
+    bool openRead(const char *path) {
+        struct stat fileStat;
+        int fd;
+
+        close();
+
+        if ((fd = open(path, O_RDONLY)) < 0)
+            return false;
+
+        if (fstat(fd, &fileStat) != 0) {
+            ::close(fd);
+
+            return false;
+        }
+
+        bool result = map(fd, fileStat.st_size, PROT_READ, MAP_PRIVATE);
+        ::close(fd);
+
+        return result;
+    }
+
+    /** Maps an existing file read-write, so it can be modified in place. @return true on success */
+    bool openWrite(const char *path) {
+        struct stat fileStat;
+        int fd;
+
+        close();
+
+        if ((fd = open(path, O_RDWR)) < 0)
+            return false;
+
+        if (fstat(fd, &fileStat) != 0) {
+            ::close(fd);
+
+            return false;
+        }
+
+        bool result = map(fd, fileStat.st_size, PROT_READ | PROT_WRITE, MAP_SHARED);
+        ::close(fd);
+
+        return result;
+    }
+
+    /** Creates (or truncates) a file of the given size and maps it read-write. @return true on success */
+    bool create(const char *path, size_t size) {
+        int fd;
+
+        close();
+
+        if ((fd = open(path, O_RDWR | O_CREAT | O_TRUNC, 0644)) < 0)
+            return false;
+
+        if (ftruncate(fd, size) != 0) {
+            ::close(fd);
+
+            return false;
+        }
+
+        bool result = map(fd, size, PROT_READ | PROT_WRITE, MAP_SHARED);
+        ::close(fd);
+
+        return result;
+    }
+
+    /** Unmaps the file, changes made to a read-write mapping are written back by the system. */
+    void close() {
+        if (mapped != nullptr)
+            munmap(mapped, mappedSize);
+
+        mapped = nullptr;
+        mappedSize = 0;
+    }
+
+    inline unsigned char *data() const {
+        return mapped;
+    }
+
+    inline size_t size() const {
+        return mappedSize;
+    }
+
+private:
+    bool map(int fd, size_t size, int prot, int flags) {
+        mappedSize = size;
+
+        if (size == 0)
+            return true;
+
+        void *addr = mmap(nullptr, size, prot, flags, fd, 0);
+
+        if (addr == MAP_FAILED) {
+            mappedSize = 0;
+
+            return false;
+        }
+
+        mapped = (unsigned char *) addr;
+
+        return true;
+    }
+
+    unsigned char *mapped = nullptr;
+    size_t mappedSize = 0;
+};
+
+
+#endif //_MAPPED_FILE_HPP_
@@ -0,0 +1,134 @@
+#ifndef _THREAD_TEAM_HPP_
+#define _THREAD_TEAM_HPP_
+
+/**
+ * Thread team implementation.
+ *
+ * (c) 2023 Marcin Piątkowski, marcin.piatkowski(at)mat.umk.pl
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include <algorithm>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+
+/**
+ * A fixed team of threads executing the same task in lockstep.
+ *
+ * Each call to run() executes task(threadId, numThreads) once on every thread of the team
+ * (the calling thread acts as the thread 0) and returns after all of them are finished.
+ * Worker threads are created once and reused, so run() is cheap enough to be called
+ * for every block of a blocked scan.
+ */
+class ThreadTeam {
+public:
+    /** Creates a team of numThreads threads (0 means the number of hardware threads). */
+    explicit ThreadTeam(unsigned numThreads = 0) {
+        if (numThreads == 0)
+            numThreads = std::max(1U, std::thread::hardware_concurrency());
+
+        for (unsigned id = 1; id < numThreads; ++id)
+            workers.emplace_back(&ThreadTeam::work, this, id);
+    }
+
+    ThreadTeam(const ThreadTeam &) = delete;
+    ThreadTeam &operator=(const ThreadTeam &) = delete;
+
+    virtual ~ThreadTeam() {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            stop = true;
+        }
+
+        started.notify_all();
+
+        for (auto &worker : workers)
+            worker.join();
+    }
+
+    inline unsigned size() const {
+        return workers.size() + 1;
+    }
+
+    /** Executes task(threadId, numThreads) on all threads of the team and waits for completion. */
+    void run(const std::function<void(unsigned, unsigned)> &task) {
+        if (workers.empty()) {
+            task(0, 1);
+
+            return;
+        }
+
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            current = &task;
+            pending = workers.size();
+            ++generation;
+        }
+
+        started.notify_all();
+        task(0, size());
+
+        std::unique_lock<std::mutex> lock(mutex);
+        finished.wait(lock, [this]() { return pending == 0; });
+    }
+
+private:
+    void work(unsigned id) {
+        unsigned long seen = 0;
+
+        for (;;) {
+            const std::function<void(unsigned, unsigned)> *task;
+
+            {
+                std::unique_lock<std::mutex> lock(mutex);
+                started.wait(lock, [&]() { return stop || generation != seen; });
+
+                if (stop)
+                    return;
+
+                seen = generation;
+                task = current;
+            }
+
+            (*task)(id, size());
+
+            std::lock_guard<std::mutex> lock(mutex);
+
+            if (--pending == 0)
+                finished.notify_one();
+        }
+    }
+
+    std::vector<std::thread> workers;
+    std::mutex mutex;
+    std::condition_variable started;
+    std::condition_variable finished;
+    const std::function<void(unsigned, unsigned)> *current = nullptr;
+    unsigned long generation = 0;
+    unsigned pending = 0;
+    bool stop = false;
+};
+
+
+#endif //_THREAD_TEAM_HPP_
@@ -25,20 +25,34 @@
  * SOFTWARE.
  */
 
+#include <optional>
+#include <vector>
+
 #include "BitVector.hpp"
+#include "Int40.hpp"
+#include "ThreadTeam.hpp"
 #include "lyndon.hpp"
+#include "bbwt_alphabet.hpp"
 #include "bbwt_internal.hpp"
+#include "bbwt_stats.hpp"
+#include "bbwt_workspace.hpp"
 
 
 /** Computes the circular suffix array of inStr.
  * @param inStr input data buffer
  * @param csa buffer where computed circular suffix array is stored
+ *        (its elements may be narrower than Tnum, e.g. Int40 for Tnum = long)
  * @param len the size of the input data
- * @param alphSize size of the alphabet
+ * @param alphSize size of the alphabet (0 means that the alphabet is computed from the input data,
+ *        wide symbols are then mapped to their ranks in a temporary copy of the input)
+ * @param numThreads the number of threads used for Lyndon factorisation and induced sorting (0 means the number of hardware threads)
+ * @param stats if given, the time and memory usage of all phases are recorded (see BbwtStats)
+ * @param ws if given, all working memory is taken from the workspace (see BbwtWorkspace)
  * @return 0 after successful computation, non-zero in case of any error
  */
-template<typename Tdata, typename Tnum>
-int circularSuffixArray(const Tdata *inStr, Tnum *csa, Tnum len, const Tnum alphSize = 256) {
+template<typename Tdata, typename Tnum, typename Tsa, typename Tstats = NoStats>
+int circularSuffixArray(const Tdata *inStr, Tsa *csa, Tnum len, Tnum alphSize = 0, unsigned numThreads = 1,
+                        Tstats *stats = nullptr, BbwtWorkspace<Tnum> *ws = nullptr) {
 
     //------------------------------------------------------------------------------------------------------------------
     // Incorrect and trivial input data
@@ -57,18 +71,93 @@ int circularSuffixArray(const Tdata *inStr, Tnum *csa, Tnum len, const Tnum alph
         return 0;
     }
 
+    //------------------------------------------------------------------------------------------------------------------
+    // Find the effective alphabet of the input data. Small non-negative symbols are sorted directly with buckets
+    // for all values up to the largest one, other ones are replaced with their ranks.
+    //------------------------------------------------------------------------------------------------------------------
+
+    std::vector<Tdata> rankStr;
+
+    if (alphSize == 0) {
+        if (stats)
+            stats->phase(BbwtPhase::AlphabetCompaction);
+
+        try {
+            EffectiveAlphabet<Tdata> alphabet(inStr, len);
+
+            if (alphabet.isDirect()) {
+                alphSize = (Tnum) alphabet.maxSymbol() + 1;
+            }
+            else {
+                rankStr.resize(len);
+                alphabet.encode(inStr, rankStr.data(), len);
+                inStr = rankStr.data();
+                alphSize = (Tnum) alphabet.size();
+            }
+        }
+        catch (const std::bad_alloc &e) {
+            return -1;
+        }
+
+        if (stats) {
+            stats->allocated(rankStr.capacity() * sizeof(Tdata));
+            stats->endPhase();
+        }
+    }
+
     //------------------------------------------------------------------------------------------------------------------
     // Compute Lyndon factorisation of the input data
     //------------------------------------------------------------------------------------------------------------------
 
-    BitVector<Tnum> lFac(len + 1);
-    lyndonFactors(inStr, len, &lFac);
+    if (stats)
+        stats->phase(BbwtPhase::LyndonFactorisation);
+
+    std::optional<BbwtWorkspace<Tnum>> localWs;
+
+    if (ws == nullptr)
+        ws = &localWs.emplace();
+
+    BitVector<Tnum> &lFac = ws->lFac;
+
+    try {
+        lFac.reset(len + 1);
+    }
+    catch (const std::bad_alloc &e) {
+        return -1;
+    }
+
+    lyndonFactors(inStr, len, &lFac, (BitVector<Tnum> *) nullptr, numThreads);
+    lFac.buildRankSelect();
+
+    if (stats) {
+        stats->allocated(lFac.memoryUsage());
+        stats->endPhase();
+    }
 
     //------------------------------------------------------------------------------------------------------------------
     // Compute Circular Suffix Array using modified SAIS algorithm
     //------------------------------------------------------------------------------------------------------------------
 
-    return circularSuffixArray(inStr, csa, len, lFac, alphSize);
+    int result;
+
+    if (numThreads == 1) {
+        result = circularSuffixArray(inStr, csa, len, lFac, alphSize, (ThreadTeam *) nullptr, stats, ws);
+    }
+    else {
+        ThreadTeam team(numThreads);
+        result = circularSuffixArray(inStr, csa, len, lFac, alphSize, &team, stats, ws);
+    }
+
+    return result;
+}
+
+
+/** Computes the circular suffix array of inStr using the given workspace (see BbwtWorkspace).
+ * @return 0 after successful computation, non-zero in case of any error
+ */
+template<typename Tdata, typename Tnum, typename Tsa>
+int circularSuffixArray(const Tdata *inStr, Tsa *csa, Tnum len, BbwtWorkspace<Tnum> &ws, const Tnum alphSize = 0) {
+    return circularSuffixArray(inStr, csa, len, alphSize, 1, (NoStats *) nullptr, &ws);
 }
 
 
@@ -77,12 +166,19 @@ int circularSuffixArray(const Tdata *inStr, Tnum *csa, Tnum len, const Tnum alph
  * @param inStr input data buffer
  * @param outStr buffer where the computed BBWT is stored (may be the same as inStr)
  * @param csa memory buffer where circular suffix array will be stored
+ *        (its elements may be narrower than Tnum, e.g. Int40 for Tnum = long);
+ *        if outStr overlaps inStr, BBWT is stored in csa first, so csa is overwritten
  * @param len the size of the input data
- * @param alphSize size of the alphabet
+ * @param alphSize size of the alphabet (0 means that the alphabet is computed from the input data,
+ *        wide symbols are then mapped to their ranks, see EffectiveAlphabet)
+ * @param numThreads the number of threads used for Lyndon factorisation and induced sorting (0 means the number of hardware threads)
+ * @param stats if given, the time and memory usage of all phases are recorded (see BbwtStats)
+ * @param ws if given, all working memory is taken from the workspace (see BbwtWorkspace)
  * @return 0 after successful computation, non-zero in case of any error
  */
-template<typename Tdata, typename Tnum>
-int bbwt(const Tdata *inStr, Tdata *outStr, Tnum *csa, Tnum len, const Tnum alphSize = 256) {
+template<typename Tdata, typename Tnum, typename Tsa, typename Tstats = NoStats>
+int bbwt(const Tdata *inStr, Tdata *outStr, Tsa *csa, Tnum len, Tnum alphSize = 0, unsigned numThreads = 1,
+         Tstats *stats = nullptr, BbwtWorkspace<Tnum> *ws = nullptr) {
 
     //------------------------------------------------------------------------------------------------------------------
     // Incorrect and trivial input data
@@ -98,77 +194,161 @@ int bbwt(const Tdata *inStr, Tdata *outStr, Tnum *csa, Tnum len, const Tnum alph
     if (len == 1) {
         outStr[0] = inStr[0];
 
+        if (csa)
+            csa[0] = 0;
+
         return 0;
     }
 
     //------------------------------------------------------------------------------------------------------------------
-    // Compute Lyndon factorisation of the input data
+    // Find the effective alphabet of the input data. Non-negative symbols below MaxDirectAlphabetSize are used directly,
+    // other ones are mapped to their ranks (into the output buffer). The mapping preserves the order of symbols,
+    // so it does not change the order of conjugates.
     //------------------------------------------------------------------------------------------------------------------
 
-    BitVector<Tnum> lFac(len + 1);    // All Lyndon factors
-    BitVector<Tnum> lFirst(len + 1);  // Only the first occurrence of each Lyndon factor
+    std::optional<EffectiveAlphabet<Tdata>> alphabet;
+    const Tdata *workStr = inStr;
+    bool mapped = false;
 
-    lyndonFactors(inStr, len, &lFac, &lFirst);
+    if (alphSize == 0) {
+        if (stats)
+            stats->phase(BbwtPhase::AlphabetCompaction);
+
+        try {
+            alphabet.emplace(inStr, len);
+        }
+        catch (const std::bad_alloc &e) {
+            return -1;
+        }
+
+        alphSize = (Tnum) alphabet->size();
+
+        if (alphabet->isIdentity() || alphabet->isDirect()) {
+            alphSize = (Tnum) alphabet->maxSymbol() + 1;
+        }
+        else {
+            alphabet->encode(inStr, outStr, len);
+            workStr = outStr;
+            mapped = true;
+        }
+
+        if (stats)
+            stats->endPhase();
+    }
 
     //------------------------------------------------------------------------------------------------------------------
-    // Compute circular suffix array for the input data
+    // Compute Lyndon factorisation of the input data
     //------------------------------------------------------------------------------------------------------------------
 
-    circularSuffixArray(inStr, csa, len, lFac, alphSize);
+    if (stats)
+        stats->phase(BbwtPhase::LyndonFactorisation);
+
+    std::optional<BbwtWorkspace<Tnum>> localWs;
+
+    if (ws == nullptr)
+        ws = &localWs.emplace();
+
+    BitVector<Tnum> &lFac = ws->lFac;
+
+    try {
+        lFac.reset(len + 1);
+    }
+    catch (const std::bad_alloc &e) {
+        return -1;
+    }
+
+    lyndonFactors(workStr, len, &lFac, (BitVector<Tnum> *) nullptr, numThreads);
+    lFac.buildRankSelect();
+
+    if (stats) {
+        stats->allocated(lFac.memoryUsage());
+        stats->endPhase();
+    }
 
     //------------------------------------------------------------------------------------------------------------------
-    // Retrieve Bijective Burrows-Wheeler Transform from circular suffix array.
-    // If the input and output buffer have a non-empty overlap use suffix array buffer as a temporary storage.
+    // Compute circular suffix array for the input data, BBWT is emitted during its final induction.
+    // If the output buffer is not available (it overlaps the input data or holds its mapped version), the symbols are
+    // stored in csa and copied afterwards, as no entry of csa is needed after it has been emitted.
     //------------------------------------------------------------------------------------------------------------------
 
-    if (inStr > outStr + len || outStr > inStr + len) {
-        for (Tnum outPos = 0; outPos < len; ++outPos) {
-            Tnum inPos = csa[outPos];
+    const bool outputInCsa = !(inStr + len <= outStr || outStr + len <= inStr);
+    const bool emitOutput = outputInCsa || !mapped;
 
-            // Wrap around the Lyndon factor if needded
-            if (lFac.get(inPos)) {
-                inPos = lFac.next(inPos) - 1;
-            } 
-            else {
-                --inPos;
-            }
+    auto emit = [&](Tnum row, Tnum pos) {
+        if (outputInCsa)
+            csa[row] = workStr[pos];
+        else
+            outStr[row] = inStr[pos];
+    };
 
-            outStr[outPos] = inStr[inPos];
-        }
+    auto computeCsa = [&](ThreadTeam *team) {
+        if (!emitOutput)
+            return circularSuffixArray(workStr, csa, len, lFac, alphSize, team, stats, ws);
+
+        return circularSuffixArray(workStr, csa, len, lFac, alphSize, team, stats, ws, emit);
+    };
+
+    int result;
+
+    if (numThreads == 1) {
+        result = computeCsa(nullptr);
     }
     else {
-        for (Tnum outPos = 0; outPos < len; ++outPos) {
-            Tnum inPos = csa[outPos];
+        ThreadTeam team(numThreads);
+        result = computeCsa(&team);
+    }
 
-            // Wrap around the Lyndon factor if needed
-            if (lFac.get(inPos)) {
-                inPos = lFac.next(inPos) - 1;
-            } 
-            else {
-                --inPos;
-            }
+    if (result != 0)
+        return result;
 
-            csa[outPos] = inStr[inPos];
-        }
+    //------------------------------------------------------------------------------------------------------------------
+    // Retrieve Bijective Burrows-Wheeler Transform
+    //------------------------------------------------------------------------------------------------------------------
+
+    if (stats)
+        stats->phase(BbwtPhase::Retrieval);
 
+    if (outputInCsa) {
         for (Tnum pos = 0; pos < len; ++pos) {
-            outStr[pos] = (unsigned char) csa[pos];
+            outStr[pos] = (Tdata) csa[pos];
         }
+
+        // The original symbols were overwritten with their ranks, so the ranks are mapped back
+        if (mapped)
+            alphabet->decode(outStr, outStr, len);
     }
+    else if (mapped) {
+        // The output buffer holds the mapped input data during the computation
+        bbwtFromCsa(inStr, outStr, csa, len, lFac);
+    }
+
+    if (stats)
+        stats->endPhase();
 
     return 0;
 }
 
 
+/** Computes Bijective Burows-Wheeler Transform of inStr using the given workspace (see BbwtWorkspace).
+ * @return 0 after successful computation, non-zero in case of any error
+ */
+template<typename Tdata, typename Tnum, typename Tsa>
+int bbwt(const Tdata *inStr, Tdata *outStr, Tsa *csa, Tnum len, BbwtWorkspace<Tnum> &ws, const Tnum alphSize = 0) {
+    return bbwt(inStr, outStr, csa, len, alphSize, 1, (NoStats *) nullptr, &ws);
+}
+
+
 /** Computes the inverse of Bijective Burrows-Wheeler Transform of inStr.
  * @param inStr input data
- * @param outStr buffer where the computed inverse of BBWT is stored
+ * @param outStr buffer where the computed inverse of BBWT is stored (different from inStr)
  * @param len the size of the input data
- * @param alphSize size of the alphabet
+ * @param alphSize size of the alphabet (0 means that symbols are counted in the effective alphabet of the input data)
+ * @param numThreads the number of threads used (0 means the number of hardware threads)
+ * @param ws if given, all working memory is taken from the workspace (see BbwtWorkspace)
  * @return 0 after successful computation, non-zero in case of any error
  */
 template<typename Tdata, typename Tnum>
-int unbbwt(const Tdata *inStr, Tdata *outStr, Tnum len, const Tnum alphSize = 256) {
+int unbbwt(const Tdata *inStr, Tdata *outStr, Tnum len, Tnum alphSize = 0, unsigned numThreads = 1, BbwtWorkspace<Tnum> *ws = nullptr) {
     const Tnum MaxVal = std::numeric_limits<Tnum>::max();
 
     //------------------------------------------------------------------------------------------------------------------
@@ -188,20 +368,78 @@ int unbbwt(const Tdata *inStr, Tdata *outStr, Tnum len, const Tnum alphSize = 25
         return 0;
     }
 
-    std::vector<Tnum> charsCount(alphSize, 0);
-    std::vector<Tnum> charsBefore(alphSize, 0);
-    std::vector<Tnum> charsSeen(alphSize, 0);
-    Tnum *stdPerm = new Tnum[len];
+    //------------------------------------------------------------------------------------------------------------------
+    // The standard permutation only depends on the order of symbols. Small non-negative symbols are counted directly,
+    // other ones are replaced with their ranks in the effective alphabet (stored temporarily in the output buffer).
+    //------------------------------------------------------------------------------------------------------------------
+
+    const Tdata *rankStr = inStr;
+
+    if (alphSize == 0) {
+        try {
+            EffectiveAlphabet<Tdata> alphabet(inStr, len);
+
+            if (alphabet.isDirect()) {
+                alphSize = (Tnum) alphabet.maxSymbol() + 1;
+            }
+            else {
+                alphabet.encode(inStr, outStr, len);
+                rankStr = outStr;
+                alphSize = (Tnum) alphabet.size();
+            }
+        }
+        catch (const std::bad_alloc &e) {
+            return -1;
+        }
+    }
+
+    std::optional<BbwtWorkspace<Tnum>> localWs;
+
+    if (ws == nullptr)
+        ws = &localWs.emplace();
+
+    try {
+        ws->stdPerm.resize(len);
+        ws->charsCount.assign(alphSize, 0);
+        ws->charsBefore.assign(alphSize, 0);
+        ws->charsSeen.assign(alphSize, 0);
+    }
+    catch (const std::bad_alloc &e) {
+        return -1;
+    }
+
+    Tnum *stdPerm = ws->stdPerm.data();
+
+    //------------------------------------------------------------------------------------------------------------------
+    // Long inputs are decoded along many segments of the cycles at once (possibly by many threads)
+    //------------------------------------------------------------------------------------------------------------------
+
+    if (len >= MinInterleavedDecodeLength) {
+        ThreadTeam team(numThreads);
+
+        computeStandardPermutation(rankStr, stdPerm, len, alphSize, team);
+        decodeCyclesInterleaved(inStr, outStr, stdPerm, len, team);
+
+        return 0;
+    }
+
+    //------------------------------------------------------------------------------------------------------------------
+    // Short inputs are decoded one cycle at a time
+    //------------------------------------------------------------------------------------------------------------------
+
+    std::vector<Tnum> &charsCount = ws->charsCount;
+    std::vector<Tnum> &charsBefore = ws->charsBefore;
+    std::vector<Tnum> &charsSeen = ws->charsSeen;
 
     for (Tnum i=0; i<len; ++i)
-        ++charsCount[inStr[i]];
+        ++charsCount[rankStr[i]];
 
     for (Tnum i=1; i<alphSize; ++i)
         charsBefore[i] = charsBefore[i-1] + charsCount[i-1];
 
     for (Tnum i=0; i<len; ++i) {
-        stdPerm[i] = charsBefore[inStr[i]] + charsSeen[inStr[i]];
-        ++charsSeen[inStr[i]];
+        stdPerm[i] = charsBefore[rankStr[i]] + charsSeen[rankStr[i]];
+        ++charsSeen[rankStr[i]];
     }
 
     Tnum outPos = len - 1;
@@ -221,7 +459,215 @@ int unbbwt(const Tdata *inStr, Tdata *outStr, Tnum len, const Tnum alphSize = 25
         }
     }
 
-    delete[] stdPerm;
+    return 0;
+}
+
+
+/** Computes the inverse of Bijective Burrows-Wheeler Transform of inStr using the given workspace (see BbwtWorkspace).
+ * @return 0 after successful computation, non-zero in case of any error
+ */
+template<typename Tdata, typename Tnum>
+int unbbwt(const Tdata *inStr, Tdata *outStr, Tnum len, BbwtWorkspace<Tnum> &ws, const Tnum alphSize = 0) {
+    return unbbwt(inStr, outStr, len, alphSize, 1, &ws);
+}
+
+
+/** Computes the extended Burrows-Wheeler Transform (eBWT) of a collection of strings.
+ * All rotations of all strings are sorted with respect to the omega-order (i.e. comparing their infinite powers),
+ * hence no separators are needed. The eBWT of the collection equals BBWT of the minimal rotations of all strings
+ * concatenated in non-increasing order, so it is computed with the same induced sorting as BBWT.
+ * Apart from sorting the rotations (O(n log k) character comparisons in the worst case) the computation takes linear time.
+ * @param inStr concatenation of all strings of the collection
+ * @param lengths the lengths of consecutive strings in inStr
+ * @param numStrings the number of strings in the collection
+ * @param outStr buffer where the computed eBWT is stored (may be the same as inStr)
+ * @param csa memory buffer of the size of inStr where circular suffix array will be stored
+ * @param alphSize size of the alphabet (0 means that the alphabet is computed from the input data,
+ *        symbols are then mapped to their ranks if needed, see EffectiveAlphabet)
+ * @param numThreads the number of threads used for Lyndon factorisation and induced sorting (0 means the number of hardware threads)
+ * @return 0 after successful computation, non-zero in case of any error
+ */
+template<typename Tdata, typename Tnum>
+int ebwt(const Tdata *inStr, const Tnum *lengths, Tnum numStrings, Tdata *outStr, Tnum *csa, Tnum alphSize = 0, unsigned numThreads = 1) {
+
+    //------------------------------------------------------------------------------------------------------------------
+    // Incorrect and trivial input data
+    //------------------------------------------------------------------------------------------------------------------
+
+    if (inStr == nullptr || outStr == nullptr || (lengths == nullptr && numStrings > 0)) {
+        return -1;
+    }
+
+    Tnum len = 0;
+
+    for (Tnum i=0; i<numStrings; ++i) {
+        if (lengths[i] < 0 || lengths[i] > std::numeric_limits<Tnum>::max() - len)
+            return -1;
+
+        len += lengths[i];
+    }
+
+    if (len == 0)
+        return 0;
+
+    if (len == 1) {
+        outStr[0] = inStr[0];
+
+        return 0;
+    }
+
+    //------------------------------------------------------------------------------------------------------------------
+    // Find the minimal rotation u^k (u being a Lyndon word) of each string
+    //------------------------------------------------------------------------------------------------------------------
+
+    struct Conjugate {
+        Tnum start, length, rotation;
+    };
+
+    std::vector<Conjugate> conjugates;
+
+    try {
+        conjugates.reserve(numStrings);
+    }
+    catch (const std::bad_alloc &e) {
+        return -1;
+    }
+
+    for (Tnum i=0, start=0; i<numStrings; start+=lengths[i], ++i) {
+        if (lengths[i] > 0)
+            conjugates.push_back({start, lengths[i], minimalRotation(inStr + start, lengths[i])});
+    }
+
+    auto charAt = [inStr](const Conjugate &c, Tnum i) {
+        Tnum pos = c.rotation + i;
+
+        return inStr[c.start + ((pos < c.length) ? pos : pos - c.length)];
+    };
+
+    //------------------------------------------------------------------------------------------------------------------
+    // Concatenate the rotations in lexicographically non-increasing order, so that the Lyndon factorisation
+    // of the concatenation consists exactly of the Lyndon roots u of all strings (as the induced sorting requires)
+    //------------------------------------------------------------------------------------------------------------------
+
+    std::sort(conjugates.begin(), conjugates.end(), [&](const Conjugate &a, const Conjugate &b) {
+        Tnum common = std::min(a.length, b.length);
+
+        for (Tnum i=0; i<common; ++i) {
+            if (charAt(a, i) != charAt(b, i))
+                return charAt(a, i) > charAt(b, i);
+        }
+
+        return a.length > b.length;
+    });
+
+    std::vector<Tdata> rotBuffer;
+    BitVector<Tnum> lFac(0);
+
+    try {
+        rotBuffer.resize(len);
+        lFac.reset(len + 1);
+    }
+    catch (const std::bad_alloc &e) {
+        return -1;
+    }
+
+    Tdata *rotStr = rotBuffer.data();
+
+    Tnum outPos = 0;
+
+    for (const Conjugate &c : conjugates) {
+        for (Tnum i=0; i<c.length; ++i)
+            rotStr[outPos++] = charAt(c, i);
+    }
+
+    //------------------------------------------------------------------------------------------------------------------
+    // Find the effective alphabet of the collection. Symbols which cannot be used directly are mapped to their ranks
+    // in the concatenation of rotations (the mapping preserves the order of symbols, so it does not change eBWT).
+    //------------------------------------------------------------------------------------------------------------------
+
+    std::optional<EffectiveAlphabet<Tdata>> alphabet;
+    bool mapped = false;
+
+    if (alphSize == 0) {
+        try {
+            alphabet.emplace(rotStr, len);
+        }
+        catch (const std::bad_alloc &e) {
+            return -1;
+        }
+
+        if (alphabet->isIdentity() || alphabet->isDirect()) {
+            alphSize = (Tnum) alphabet->maxSymbol() + 1;
+        }
+        else {
+            alphabet->encode(rotStr, rotStr, len);
+            alphSize = (Tnum) alphabet->size();
+            mapped = true;
+        }
+    }
+
+    lyndonFactors(rotStr, len, &lFac, (BitVector<Tnum> *) nullptr, numThreads);
+    lFac.buildRankSelect();
+
+    //------------------------------------------------------------------------------------------------------------------
+    // Compute circular suffix array of the collection, eBWT is emitted during its final induction
+    //------------------------------------------------------------------------------------------------------------------
+
+    auto emit = [&](Tnum row, Tnum pos) {
+        outStr[row] = rotStr[pos];
+    };
+
+    int result;
+
+    if (numThreads == 1) {
+        result = circularSuffixArray(rotStr, csa, len, lFac, alphSize, (ThreadTeam *) nullptr, (NoStats *) nullptr, (BbwtWorkspace<Tnum> *) nullptr, emit);
+    }
+    else {
+        ThreadTeam team(numThreads);
+        result = circularSuffixArray(rotStr, csa, len, lFac, alphSize, &team, (NoStats *) nullptr, (BbwtWorkspace<Tnum> *) nullptr, emit);
+    }
+
+    if (result == 0 && mapped)
+        alphabet->decode(outStr, outStr, len);
+
+    return result;
+}
+
+
+/** Computes the inverse of extended Burrows-Wheeler Transform of inStr.
+ * The eBWT determines the collection only up to the order of strings and their rotations. Moreover, a power u^k
+ * has the same eBWT as k copies of u. Therefore the collection is restored as the multiset of primitive strings,
+ * each of them being a Lyndon word, in lexicographically non-increasing order.
+ * @param inStr input data
+ * @param outStr buffer where the concatenation of restored strings is stored
+ * @param lengths buffer (of at least len entries) where the lengths of consecutive restored strings are stored
+ * @param numStrings where the number of restored strings is stored
+ * @param len the size of the input data
+ * @param alphSize size of the alphabet (0 means that symbols are counted in the effective alphabet of the input data)
+ * @param numThreads the number of threads used (0 means the number of hardware threads)
+ * @return 0 after successful computation, non-zero in case of any error
+ */
+template<typename Tdata, typename Tnum>
+int unebwt(const Tdata *inStr, Tdata *outStr, Tnum *lengths, Tnum *numStrings, Tnum len, const Tnum alphSize = 0, unsigned numThreads = 1) {
+    if (lengths == nullptr || numStrings == nullptr) {
+        return -1;
+    }
+
+    // The eBWT of a multiset of Lyndon words is the BBWT of their concatenation in non-increasing order
+    if (unbbwt(inStr, outStr, len, alphSize, numThreads) != 0) {
+        return -1;
+    }
+
+    BitVector<Tnum> lFac(len + 1);
+
+    *numStrings = lyndonFactors(outStr, len, &lFac, (BitVector<Tnum> *) nullptr, numThreads);
+
+    for (Tnum i=0, pos=0; pos<len; ++i) {
+        Tnum next = lFac.next(pos);
+
+        lengths[i] = next - pos;
+        pos = next;
+    }
 
     return 0;
 }
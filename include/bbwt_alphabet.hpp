@@ -0,0 +1,187 @@
+#ifndef _BBWT_ALPHABET_HPP_
+#define _BBWT_ALPHABET_HPP_
+
+/*
+ * Effective alphabet of the input data.
+ *
+ * (c) 2023 Marcin Piątkowski, marcin.piatkowski(at)mat.umk.pl
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <type_traits>
+#include <unordered_set>
+#include <vector>
+
+
+/** Symbols smaller than this are counted with a table indexed by the symbol. */
+const size_t MaxDirectAlphabetSize = 1 << 16;
+
+
+/**
+ * The effective alphabet of a string, i.e. the symbols which actually occur in it, in increasing order.
+ *
+ * Every symbol is mapped to its rank in the alphabet (0..size()-1). The mapping preserves the order of symbols,
+ * hence it preserves the Lyndon factorisation and the order of all conjugates, so BBWT of the mapped string
+ * is the mapped BBWT of the original string. Symbols of at most 16 bits are mapped with a table indexed by
+ * the symbol (for bytes the table is not even allocated on the heap), wider symbols (e.g. token identifiers or
+ * Unicode code points) are collected in a hash set and mapped with binary search.
+ * If the alphabet is already dense (i.e. it consists of symbols 0..size()-1), isIdentity() is true
+ * and the mapping may be skipped. Symbols may be used as bucket indices without mapping only if isDirect() is true
+ * (in particular, negative symbols of signed types are always mapped).
+ */
+template<typename Tdata>
+class EffectiveAlphabet {
+public:
+    /** Finds all symbols of inStr[0..len). Throws std::bad_alloc if out of memory. */
+    template<typename Tnum>
+    EffectiveAlphabet(const Tdata *inStr, Tnum len) {
+        static_assert(std::is_unsigned<Tdata>::value || !Direct, "narrow symbols have to be unsigned");
+
+        if constexpr (Direct) {
+            if constexpr (sizeof(Tdata) > 1) {
+                ranks.assign(TableSize, 0);
+                symbols.resize(TableSize);
+            }
+            else {
+                ranks.fill(0);
+            }
+
+            for (Tnum i = 0; i < len; ++i)
+                ranks[(Tsym) inStr[i]] = 1;
+
+            for (size_t c = 0; c < TableSize; ++c) {
+                if (ranks[c] != 0) {
+                    symbols[numSymbols] = (Tdata) c;
+                    ranks[c] = (Tdata) numSymbols++;
+                }
+            }
+        }
+        else {
+            std::unordered_set<Tdata> seen;
+
+            for (Tnum i = 0; i < len; ++i) {
+                if (i == 0 || inStr[i] != inStr[i - 1])
+                    seen.insert(inStr[i]);
+            }
+
+            symbols.assign(seen.begin(), seen.end());
+            std::sort(symbols.begin(), symbols.end());
+            numSymbols = symbols.size();
+        }
+    }
+
+    /** The number of distinct symbols. */
+    inline size_t size() const {
+        return numSymbols;
+    }
+
+    /** Whether every symbol is equal to its rank. */
+    inline bool isIdentity() const {
+        return numSymbols == 0 || (minSymbol() == 0 && (size_t) maxSymbol() == numSymbols - 1);
+    }
+
+    /** Whether all symbols are non-negative and smaller than MaxDirectAlphabetSize (the alphabet must not be empty). */
+    inline bool isDirect() const {
+        if constexpr (std::is_signed<Tdata>::value) {
+            if (minSymbol() < 0)
+                return false;
+        }
+
+        return (size_t) maxSymbol() < MaxDirectAlphabetSize;
+    }
+
+    /** The smallest symbol (the alphabet must not be empty). */
+    inline Tdata minSymbol() const {
+        return symbols[0];
+    }
+
+    /** The largest symbol (the alphabet must not be empty). */
+    inline Tdata maxSymbol() const {
+        return symbols[numSymbols - 1];
+    }
+
+    /** Finds the rank of symbol c. @return false if c does not occur in the alphabet */
+    bool find(Tdata c, Tdata &rank) const {
+        if (numSymbols == 0)
+            return false;
+
+        if constexpr (Direct) {
+            rank = ranks[(Tsym) c];
+        }
+        else {
+            rank = (Tdata) (std::lower_bound(symbols.begin(), symbols.begin() + numSymbols, c) - symbols.begin());
+
+            if ((size_t) rank == numSymbols)
+                return false;
+        }
+
+        return symbols[(Tsym) rank] == c;
+    }
+
+    /** Replaces every symbol of inStr[0..len) with its rank (outStr may be the same as inStr). */
+    template<typename Tnum>
+    void encode(const Tdata *inStr, Tdata *outStr, Tnum len) const {
+        if constexpr (Direct) {
+            for (Tnum i = 0; i < len; ++i)
+                outStr[i] = ranks[(Tsym) inStr[i]];
+        }
+        else {
+            Tdata last = 0, lastRank = 0;
+
+            for (Tnum i = 0; i < len; ++i) {
+                Tdata c = inStr[i];
+
+                // Repeated symbols are frequent, so the last one is not searched again
+                if (i == 0 || c != last) {
+                    last = c;
+                    lastRank = (Tdata) (std::lower_bound(symbols.begin(), symbols.begin() + numSymbols, c) - symbols.begin());
+                }
+
+                outStr[i] = lastRank;
+            }
+        }
+    }
+
+    /** Replaces every rank in inStr[0..len) with its symbol (outStr may be the same as inStr). */
+    template<typename Tnum>
+    void decode(const Tdata *inStr, Tdata *outStr, Tnum len) const {
+        for (Tnum i = 0; i < len; ++i)
+            outStr[i] = symbols[(Tsym) inStr[i]];
+    }
+
+private:
+    using Tsym = std::make_unsigned_t<Tdata>;
+
+    static constexpr bool Direct = sizeof(Tdata) <= 2;
+    static constexpr size_t TableSize = Direct ? (size_t) 1 << (8 * sizeof(Tdata)) : 0;
+
+    // Bytes are mapped with fixed-size tables, so no memory is allocated
+    using Table = std::conditional_t<sizeof(Tdata) == 1, std::array<Tdata, 256>, std::vector<Tdata>>;
+
+    Table ranks;
+    Table symbols;
+    size_t numSymbols = 0;
+};
+
+
+#endif //_BBWT_ALPHABET_HPP_
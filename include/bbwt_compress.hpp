@@ -0,0 +1,480 @@
+#ifndef _BBWT_COMPRESS_HPP_
+#define _BBWT_COMPRESS_HPP_
+
+/**
+ * Block-based compression using Bijective Burrows-Wheeler Transform.
+ *
+ * Each block is transformed with BBWT, then Move-To-Front and zero run-length coding
+ * are applied and the result is encoded with a canonical Huffman code.
+ *
+ * (c) 2023 Marcin Piątkowski, marcin.piatkowski(at)mat.umk.pl
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include <cstdint>
+#include <cstring>
+#include <algorithm>
+#include <queue>
+#include <vector>
+
+#include "bbwt.hpp"
+
+
+//-------------------------------------------------------------------------------------------------
+// Container format
+//
+// Header:  magic "BBWZ", version (1 byte), 3 reserved bytes, block size (4 bytes), number of blocks (8 bytes)
+// Index:   for each block its original size (4 bytes), compressed size (4 bytes) and CRC-32 of the original data (4 bytes)
+// Data:    compressed blocks in order
+//
+// All integers are stored in little-endian byte order.
+//-------------------------------------------------------------------------------------------------
+
+const unsigned char ContainerMagic[4] = {'B', 'B', 'W', 'Z'};
+const unsigned char ContainerVersion = 1;
+const size_t ContainerHeaderSize = 20;
+const size_t ContainerIndexEntrySize = 12;
+
+/** Default size of a single block (in bytes). */
+const int DefaultBlockSize = 4 << 20;
+
+
+inline void putUInt32(unsigned char *dst, uint32_t val) {
+    for (int i=0; i<4; ++i)
+        dst[i] = (unsigned char) (val >> (8 * i));
+}
+
+inline void putUInt64(unsigned char *dst, uint64_t val) {
+    for (int i=0; i<8; ++i)
+        dst[i] = (unsigned char) (val >> (8 * i));
+}
+
+inline uint32_t getUInt32(const unsigned char *src) {
+    uint32_t val = 0;
+
+    for (int i=3; i>=0; --i)
+        val = (val << 8) | src[i];
+
+    return val;
+}
+
+inline uint64_t getUInt64(const unsigned char *src) {
+    uint64_t val = 0;
+
+    for (int i=7; i>=0; --i)
+        val = (val << 8) | src[i];
+
+    return val;
+}
+
+
+/** Computes CRC-32 (IEEE 802.3) of the given data. */
+inline uint32_t crc32(const unsigned char *data, size_t len) {
+    static const std::vector<uint32_t> table = []() {
+        std::vector<uint32_t> t(256);
+
+        for (uint32_t i=0; i<256; ++i) {
+            uint32_t c = i;
+
+            for (int k=0; k<8; ++k)
+                c = (c & 1) ? 0xEDB88320U ^ (c >> 1) : (c >> 1);
+
+            t[i] = c;
+        }
+
+        return t;
+    }();
+
+    uint32_t crc = 0xFFFFFFFFU;
+
+    for (size_t i=0; i<len; ++i)
+        crc = table[(crc ^ data[i]) & 0xFF] ^ (crc >> 8);
+
+    return crc ^ 0xFFFFFFFFU;
+}
+
+
+//-------------------------------------------------------------------------------------------------
+// Move-To-Front and zero run-length coding
+//-------------------------------------------------------------------------------------------------
+
+// Symbols 0 and 1 (RUNA, RUNB) encode the length of a run of zeros in bijective base 2,
+// Move-To-Front rank r > 0 is encoded as symbol r + 1.
+const int RunA = 0;
+const int RunB = 1;
+const int NumSymbols = 257;
+
+
+/** Appends symbols encoding a run of runLen zeros to symbols. */
+inline void putZeroRun(std::vector<uint16_t> &symbols, uint32_t runLen) {
+    while (runLen > 0) {
+        symbols.push_back((runLen & 1) ? RunA : RunB);
+        runLen = (runLen - 1) >> 1;
+    }
+}
+
+
+/**
+ * Applies Move-To-Front and zero run-length coding to inData.
+ * @param symbols The output symbols, previous content is replaced.
+ * @param freq The output symbol frequencies (NumSymbols elements).
+ */
+inline void mtfEncode(const unsigned char *inData, int len, std::vector<uint16_t> &symbols, uint32_t *freq) {
+    unsigned char order[256];
+    uint32_t runLen = 0;
+
+    for (int i=0; i<256; ++i)
+        order[i] = (unsigned char) i;
+
+    symbols.clear();
+
+    for (int pos=0; pos<len; ++pos) {
+        unsigned char c = inData[pos];
+
+        if (order[0] == c) {
+            ++runLen;
+            continue;
+        }
+
+        putZeroRun(symbols, runLen);
+        runLen = 0;
+
+        int r = 1;
+        unsigned char prev = order[0];
+
+        for (order[0] = c; order[r] != c; ++r)
+            std::swap(prev, order[r]);
+
+        order[r] = prev;
+        symbols.push_back(r + 1);
+    }
+
+    putZeroRun(symbols, runLen);
+
+    std::fill(freq, freq + NumSymbols, 0);
+
+    for (uint16_t s : symbols)
+        ++freq[s];
+}
+
+
+/**
+ * Inverts mtfEncode().
+ * @return 0 if exactly len characters were decoded, non-zero otherwise
+ */
+inline int mtfDecode(const uint16_t *symbols, size_t numSymbols, unsigned char *outData, int len) {
+    unsigned char order[256];
+    int pos = 0;
+
+    for (int i=0; i<256; ++i)
+        order[i] = (unsigned char) i;
+
+    for (size_t i=0; i<numSymbols; ) {
+        if (symbols[i] <= RunB) {
+            uint64_t runLen = 0;
+
+            for (uint64_t weight = 1; i < numSymbols && symbols[i] <= RunB && runLen <= (uint64_t) len; ++i, weight <<= 1)
+                runLen += weight << symbols[i];
+
+            if (runLen > (uint64_t) (len - pos))
+                return -1;
+
+            memset(outData + pos, order[0], runLen);
+            pos += runLen;
+        }
+        else {
+            int r = symbols[i++] - 1;
+            unsigned char c = order[r];
+
+            if (pos >= len)
+                return -1;
+
+            memmove(order + 1, order, r);
+            order[0] = c;
+            outData[pos++] = c;
+        }
+    }
+
+    return (pos == len) ? 0 : -1;
+}
+
+
+//-------------------------------------------------------------------------------------------------
+// Canonical Huffman coding
+//-------------------------------------------------------------------------------------------------
+
+/** The maximal length of a Huffman code, it is also the number of bits used for table decoding. */
+const int MaxCodeLen = 12;
+
+
+/**
+ * Computes lengths of length-limited Huffman codes for the given symbol frequencies.
+ * Symbols that do not occur get length 0. If the code is too long, the frequencies are flattened and codes rebuilt.
+ */
+inline void huffmanCodeLengths(const uint32_t *freq, int numSymbols, unsigned char *lengths) {
+    std::vector<uint64_t> weight(freq, freq + numSymbols);
+
+    for (;;) {
+        // Nodes 0..numSymbols-1 are leaves, subsequent ones are internal nodes
+        std::vector<int> parent(2 * numSymbols, -1);
+        std::priority_queue<std::pair<uint64_t, int>, std::vector<std::pair<uint64_t, int>>, std::greater<std::pair<uint64_t, int>>> heap;
+        int numNodes = numSymbols;
+
+        for (int s=0; s<numSymbols; ++s) {
+            if (weight[s] > 0)
+                heap.emplace(weight[s], s);
+        }
+
+        if (heap.size() == 1)
+            heap.emplace(0, heap.top().second == 0 ? 1 : 0);
+
+        while (heap.size() > 1) {
+            auto a = heap.top();
+            heap.pop();
+            auto b = heap.top();
+            heap.pop();
+
+            parent[a.second] = parent[b.second] = numNodes;
+            heap.emplace(a.first + b.first, numNodes++);
+        }
+
+        int maxLen = 0;
+
+        for (int s=0; s<numSymbols; ++s) {
+            int len = 0;
+
+            if (weight[s] > 0 || parent[s] >= 0) {
+                for (int n = s; parent[n] >= 0; n = parent[n])
+                    ++len;
+            }
+
+            lengths[s] = (unsigned char) len;
+            maxLen = std::max(maxLen, len);
+        }
+
+        if (maxLen <= MaxCodeLen)
+            return;
+
+        for (int s=0; s<numSymbols; ++s) {
+            if (weight[s] > 0)
+                weight[s] = (weight[s] >> 1) | 1;
+        }
+    }
+}
+
+
+/** Assigns canonical codes to symbols with the given code lengths. */
+inline void huffmanCodes(const unsigned char *lengths, int numSymbols, uint32_t *codes) {
+    uint32_t code = 0;
+
+    for (int len=1; len<=MaxCodeLen; ++len) {
+        for (int s=0; s<numSymbols; ++s) {
+            if (lengths[s] == len)
+                codes[s] = code++;
+        }
+
+        code <<= 1;
+    }
+}
+
+
+/** Writes bits (most significant first) to a byte buffer. */
+class BitWriter {
+public:
+    explicit BitWriter(std::vector<unsigned char> &out) : out(out) { }
+
+    inline void put(uint32_t code, int len) {
+        buffer = (buffer << len) | code;
+        numBits += len;
+
+        while (numBits >= 8) {
+            numBits -= 8;
+            out.push_back((unsigned char) (buffer >> numBits));
+        }
+    }
+
+    void flush() {
+        if (numBits > 0)
+            put(0, 8 - numBits);
+    }
+
+private:
+    std::vector<unsigned char> &out;
+    uint64_t buffer = 0;
+    int numBits = 0;
+};
+
+
+/** Reads bits (most significant first) from a byte buffer, reading past its end yields zero bits. */
+class BitReader {
+public:
+    BitReader(const unsigned char *data, size_t size) : data(data), end(data + size) { }
+
+    inline uint32_t peek(int len) {
+        while (numBits < len) {
+            buffer = (buffer << 8) | ((data < end) ? *data : 0);
+            ++data;
+            numBits += 8;
+        }
+
+        return (uint32_t) (buffer >> (numBits - len)) & ((1U << len) - 1);
+    }
+
+    inline void skip(int len) {
+        numBits -= len;
+    }
+
+    /** Returns true if more bits were consumed than available. */
+    inline bool overrun() const {
+        return data > end + (numBits >> 3);
+    }
+
+private:
+    const unsigned char *data;
+    const unsigned char *end;
+    uint64_t buffer = 0;
+    int numBits = 0;
+};
+
+
+//-------------------------------------------------------------------------------------------------
+// Block compression
+//
+// Block:   number of symbols (4 bytes), code lengths of all symbols (4 bits each), Huffman coded symbols
+//-------------------------------------------------------------------------------------------------
+
+const size_t CodeLengthsSize = (NumSymbols + 1) / 2;
+
+
+/** Buffers reused by a single thread across blocks. */
+struct BlockWorkspace {
+    std::vector<int> csa;
+    std::vector<unsigned char> bbwtData;
+    std::vector<uint16_t> symbols;
+    std::vector<uint16_t> decodeTable;  // Huffman decoding table indexed by the next MaxCodeLen bits
+    BbwtWorkspace<int> transform;
+};
+
+
+/**
+ * Compresses a single block.
+ * @param out buffer where the compressed block is stored (previous content is replaced)
+ * @return 0 after successful computation, non-zero in case of any error
+ */
+inline int compressBlock(const unsigned char *inData, int len, std::vector<unsigned char> &out, BlockWorkspace &ws) {
+    uint32_t freq[NumSymbols];
+    unsigned char lengths[NumSymbols + 1] = {0};
+    uint32_t codes[NumSymbols];
+
+    ws.csa.resize(len);
+    ws.bbwtData.resize(len);
+
+    if (bbwt(inData, ws.bbwtData.data(), ws.csa.data(), len, ws.transform) != 0)
+        return -1;
+
+    mtfEncode(ws.bbwtData.data(), len, ws.symbols, freq);
+    huffmanCodeLengths(freq, NumSymbols, lengths);
+    huffmanCodes(lengths, NumSymbols, codes);
+
+    out.assign(4 + CodeLengthsSize, 0);
+    putUInt32(out.data(), ws.symbols.size());
+
+    for (size_t i=0; i<CodeLengthsSize; ++i)
+        out[4 + i] = (unsigned char) ((lengths[2 * i] << 4) | lengths[2 * i + 1]);
+
+    BitWriter writer(out);
+
+    for (uint16_t s : ws.symbols)
+        writer.put(codes[s], lengths[s]);
+
+    writer.flush();
+
+    return 0;
+}
+
+
+/**
+ * Decompresses a single block of len characters.
+ * @return 0 after successful computation, non-zero in case of any error (e.g. corrupted data)
+ */
+inline int decompressBlock(const unsigned char *inData, size_t size, unsigned char *outData, int len, BlockWorkspace &ws) {
+    unsigned char lengths[NumSymbols + 1];
+    uint32_t codes[NumSymbols];
+
+    if (size < 4 + CodeLengthsSize)
+        return -1;
+
+    uint32_t numSymbols = getUInt32(inData);
+
+    for (size_t i=0; i<CodeLengthsSize; ++i) {
+        lengths[2 * i] = inData[4 + i] >> 4;
+        lengths[2 * i + 1] = inData[4 + i] & 15;
+    }
+
+    // Each decoding table entry holds a symbol and its code length
+    huffmanCodes(lengths, NumSymbols, codes);
+
+    std::vector<uint16_t> &table = ws.decodeTable;
+    table.assign(1 << MaxCodeLen, 0);
+
+    for (int s=0; s<NumSymbols; ++s) {
+        if (lengths[s] == 0)
+            continue;
+
+        if (lengths[s] > MaxCodeLen || (codes[s] >> lengths[s]) != 0)
+            return -1;
+
+        uint32_t first = codes[s] << (MaxCodeLen - lengths[s]);
+        uint32_t last = (codes[s] + 1) << (MaxCodeLen - lengths[s]);
+
+        for (uint32_t e = first; e < last; ++e)
+            table[e] = (uint16_t) ((s << 4) | lengths[s]);
+    }
+
+    // Every symbol produces at least one character
+    if (numSymbols > (uint32_t) len)
+        return -1;
+
+    ws.symbols.resize(numSymbols);
+    BitReader reader(inData + 4 + CodeLengthsSize, size - 4 - CodeLengthsSize);
+
+    for (uint32_t i=0; i<numSymbols; ++i) {
+        uint16_t entry = table[reader.peek(MaxCodeLen)];
+
+        if ((entry & 15) == 0)
+            return -1;
+
+        reader.skip(entry & 15);
+        ws.symbols[i] = entry >> 4;
+    }
+
+    if (reader.overrun())
+        return -1;
+
+    ws.bbwtData.resize(len);
+
+    if (mtfDecode(ws.symbols.data(), numSymbols, ws.bbwtData.data(), len) != 0)
+        return -1;
+
+    return unbbwt(ws.bbwtData.data(), outData, len, ws.transform);
+}
+
+
+#endif //_BBWT_COMPRESS_HPP_
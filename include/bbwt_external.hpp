@@ -0,0 +1,662 @@
+#ifndef _BBWT_EXTERNAL_HPP_
+#define _BBWT_EXTERNAL_HPP_
+
+/*
+ * External-memory Bijective Burrows-Wheeler Transform construction.
+ *
+ * (c) 2023 Marcin Piątkowski, marcin.piatkowski(at)mat.umk.pl
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdlib>
+#include <memory>
+#include <new>
+#include <queue>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <fcntl.h>
+#include <unistd.h>
+
+#include "MappedFile.hpp"
+#include "lyndon.hpp"
+
+
+/** The smallest memory budget accepted by bbwtExternal(). */
+const size_t MinExternalMemory = 1 << 16;
+
+
+//-------------------------------------------------------------------------------------------------
+// Temporary files
+//-------------------------------------------------------------------------------------------------
+
+/** Reads up to bytes bytes at the given offset. @return the number of bytes read (less at the end of file) or -1 */
+inline ssize_t readFully(int fd, void *data, size_t bytes, uint64_t offset) {
+    size_t done = 0;
+
+    while (done < bytes) {
+        ssize_t count = pread(fd, (char *) data + done, bytes - done, offset + done);
+
+        if (count < 0)
+            return -1;
+
+        if (count == 0)
+            break;
+
+        done += count;
+    }
+
+    return done;
+}
+
+
+/** Writes bytes bytes at the given offset. @return true on success */
+inline bool writeFully(int fd, const void *data, size_t bytes, uint64_t offset) {
+    size_t done = 0;
+
+    while (done < bytes) {
+        ssize_t count = pwrite(fd, (const char *) data + done, bytes - done, offset + done);
+
+        if (count <= 0)
+            return false;
+
+        done += count;
+    }
+
+    return true;
+}
+
+
+/**
+ * A temporary file in the given directory. The file is unlinked right after creation,
+ * so it is removed as soon as it is closed (also if the program is interrupted).
+ */
+class TempFile {
+public:
+    explicit TempFile(const std::string &dir) {
+        std::string path = dir + "/bbwt-XXXXXX";
+
+        if ((fd = mkstemp(path.data())) >= 0)
+            unlink(path.c_str());
+    }
+
+    TempFile(const TempFile &) = delete;
+    TempFile &operator=(const TempFile &) = delete;
+
+    virtual ~TempFile() {
+        if (fd >= 0)
+            close(fd);
+    }
+
+    inline bool good() const {
+        return fd >= 0;
+    }
+
+    inline int descriptor() const {
+        return fd;
+    }
+
+private:
+    int fd = -1;
+};
+
+
+/** Buffered sequential writer of records of type T, starting at the record with the given index. */
+template<typename T>
+class RecordWriter {
+public:
+    RecordWriter(int fd, size_t blockBytes, uint64_t first = 0) : fd(fd), offset(first * sizeof(T)) {
+        buffer.reserve(std::max((size_t) 1, blockBytes / sizeof(T)));
+    }
+
+    inline void write(const T &value) {
+        buffer.push_back(value);
+
+        if (buffer.size() == buffer.capacity())
+            flush();
+    }
+
+    /** Writes all buffered records. @return true if all records have been written successfully */
+    bool flush() {
+        if (!buffer.empty()) {
+            failed = failed || fd < 0 || !writeFully(fd, buffer.data(), buffer.size() * sizeof(T), offset);
+            offset += buffer.size() * sizeof(T);
+            buffer.clear();
+        }
+
+        return !failed;
+    }
+
+private:
+    int fd;
+    uint64_t offset;
+    std::vector<T> buffer;
+    bool failed = false;
+};
+
+
+/**
+ * Buffered reader of records of type T with indices in [first, end) (up to the end of file by default).
+ * Seeking within the current block does not need any I/O.
+ */
+template<typename T>
+class RecordReader {
+public:
+    RecordReader(int fd, size_t blockBytes, uint64_t first = 0, uint64_t end = UINT64_MAX)
+        : fd(fd), buffer(std::max((size_t) 1, blockBytes / sizeof(T))), start(first), end(end) {
+    }
+
+    /** @return false at the end of file or in case of I/O error */
+    inline bool next(T &value) {
+        if (pos == count && !fill())
+            return false;
+
+        value = buffer[pos++];
+
+        return true;
+    }
+
+    /** Moves to the record with the given index. */
+    void seek(uint64_t index) {
+        if (index >= start && index < start + count) {
+            pos = index - start;
+        }
+        else {
+            start = index;
+            pos = count = 0;
+        }
+    }
+
+    inline bool failed() const {
+        return error;
+    }
+
+private:
+    bool fill() {
+        start += count;
+        pos = count = 0;
+
+        if (start >= end)
+            return false;
+
+        size_t records = std::min((uint64_t) buffer.size(), end - start);
+        ssize_t bytes = (fd < 0) ? -1 : readFully(fd, buffer.data(), records * sizeof(T), start * sizeof(T));
+
+        if (bytes < 0)
+            error = true;
+        else
+            count = bytes / sizeof(T);
+
+        return count > 0;
+    }
+
+    int fd;
+    std::vector<T> buffer;
+    uint64_t start;
+    uint64_t end;
+    size_t pos = 0;
+    size_t count = 0;
+    bool error = false;
+};
+
+
+//-------------------------------------------------------------------------------------------------
+// External sorting
+//-------------------------------------------------------------------------------------------------
+
+/**
+ * Sorts a sequence of records of type T which does not fit into memory.
+ *
+ * Records are collected into runs of memoryBytes bytes, every run is sorted in memory and appended to
+ * a temporary file. Afterwards the runs are merged (in several passes if there are too many of them to be
+ * merged with memoryBytes bytes of buffers) and the sorted sequence is read with next(). All runs share
+ * a single file (every merge pass writes a new one), so at most two files are open at a time regardless
+ * of the number of runs. If all records fit into a single run, no temporary files are used at all.
+ */
+template<typename T, typename Compare>
+class ExternalSorter {
+public:
+    /** Throws std::bad_alloc if the run buffer cannot be allocated. */
+    ExternalSorter(size_t memoryBytes, size_t blockBytes, const std::string &tmpDir)
+        : blockBytes(blockBytes), maxFanIn(std::max((size_t) 2, memoryBytes / blockBytes - 1)), tmpDir(tmpDir) {
+        run.reserve(std::max((size_t) 1, memoryBytes / sizeof(T)));
+    }
+
+    /** @return false in case of I/O error */
+    bool push(const T &value) {
+        if (run.size() == run.capacity() && !writeRun())
+            return false;
+
+        run.push_back(value);
+
+        return true;
+    }
+
+    /** Finishes the input and prepares the sorted sequence. @return false in case of I/O error */
+    bool sort() {
+        if (runs.empty()) {
+            std::sort(run.begin(), run.end(), Compare());
+
+            return true;
+        }
+
+        if (!run.empty() && !writeRun())
+            return false;
+
+        std::vector<T>().swap(run);
+
+        // Merge groups of runs into a new file until all of them can be merged at once
+        while (runs.size() > maxFanIn) {
+            std::unique_ptr<TempFile> mergedFile(new TempFile(tmpDir));
+            RecordWriter<T> writer(mergedFile->descriptor(), blockBytes);
+            std::vector<Run> merged;
+            uint64_t written = 0;
+
+            for (size_t first = 0; first < runs.size(); first += maxFanIn) {
+                size_t last = std::min(runs.size(), first + maxFanIn);
+                Merger groupMerger(*runFile, runs, first, last, blockBytes);
+                Run result = {written, written};
+                T value;
+
+                while (groupMerger.next(value)) {
+                    writer.write(value);
+                    ++result.end;
+                }
+
+                if (groupMerger.failed())
+                    return false;
+
+                merged.push_back(result);
+                written = result.end;
+            }
+
+            if (!mergedFile->good() || !writer.flush())
+                return false;
+
+            runFile.swap(mergedFile);
+            runs.swap(merged);
+        }
+
+        merger.reset(new Merger(*runFile, runs, 0, runs.size(), blockBytes));
+
+        return !merger->failed();
+    }
+
+    /** @return false after the last record (or in case of I/O error, see failed()) */
+    inline bool next(T &value) {
+        if (merger)
+            return merger->next(value);
+
+        if (pos == run.size())
+            return false;
+
+        value = run[pos++];
+
+        return true;
+    }
+
+    inline bool failed() const {
+        return merger && merger->failed();
+    }
+
+private:
+    /** The records [start, end) of the run file. */
+    struct Run {
+        uint64_t start, end;
+    };
+
+    /** K-way merge of runs[first..last) stored in file. */
+    class Merger {
+    public:
+        Merger(const TempFile &file, const std::vector<Run> &runs, size_t first, size_t last, size_t blockBytes) {
+            for (size_t r = first; r < last; ++r) {
+                readers.emplace_back(file.descriptor(), blockBytes, runs[r].start, runs[r].end);
+
+                T value;
+
+                if (readers.back().next(value))
+                    heap.push({value, readers.size() - 1});
+            }
+        }
+
+        bool next(T &value) {
+            if (heap.empty())
+                return false;
+
+            auto top = heap.top();
+            heap.pop();
+            value = top.first;
+
+            if (readers[top.second].next(top.first))
+                heap.push(top);
+
+            return true;
+        }
+
+        bool failed() const {
+            for (const auto &reader : readers) {
+                if (reader.failed())
+                    return true;
+            }
+
+            return false;
+        }
+
+    private:
+        struct Greater {
+            bool operator()(const std::pair<T, size_t> &a, const std::pair<T, size_t> &b) const {
+                return Compare()(b.first, a.first);
+            }
+        };
+
+        std::vector<RecordReader<T>> readers;
+        std::priority_queue<std::pair<T, size_t>, std::vector<std::pair<T, size_t>>, Greater> heap;
+    };
+
+    bool writeRun() {
+        std::sort(run.begin(), run.end(), Compare());
+
+        if (!runFile)
+            runFile.reset(new TempFile(tmpDir));
+
+        uint64_t start = runs.empty() ? 0 : runs.back().end;
+        RecordWriter<T> writer(runFile->descriptor(), blockBytes, start);
+
+        for (const T &value : run)
+            writer.write(value);
+
+        if (!runFile->good() || !writer.flush())
+            return false;
+
+        runs.push_back({start, start + run.size()});
+        run.clear();
+
+        return true;
+    }
+
+    const size_t blockBytes;
+    const size_t maxFanIn;
+    const std::string tmpDir;
+    std::vector<T> run;
+    size_t pos = 0;
+    std::unique_ptr<TempFile> runFile;
+    std::vector<Run> runs;
+    std::unique_ptr<Merger> merger;
+};
+
+
+//-------------------------------------------------------------------------------------------------
+// External BBWT construction
+//-------------------------------------------------------------------------------------------------
+
+/** Ranks of a conjugate and of the conjugate shifted by h positions. */
+struct ExternalRankPair {
+    uint64_t rank1, rank2, pos;
+
+    struct ByRanks {
+        inline bool operator()(const ExternalRankPair &a, const ExternalRankPair &b) const {
+            return a.rank1 < b.rank1 || (a.rank1 == b.rank1 && a.rank2 < b.rank2);
+        }
+    };
+};
+
+
+/** The rank of the conjugate starting at pos. */
+struct ExternalPosRank {
+    uint64_t pos, rank;
+
+    struct ByPos {
+        inline bool operator()(const ExternalPosRank &a, const ExternalPosRank &b) const {
+            return a.pos < b.pos;
+        }
+    };
+};
+
+
+/** The final rank of a conjugate and its last character (the BBWT character). */
+struct ExternalRankChar {
+    uint64_t rank;
+    unsigned char c;
+
+    struct ByRank {
+        inline bool operator()(const ExternalRankChar &a, const ExternalRankChar &b) const {
+            return a.rank < b.rank;
+        }
+    };
+};
+
+
+/**
+ * Computes Bijective Burrows-Wheeler Transform of the file inPath and stores it in the file outPath,
+ * using at most about memoryBudget bytes of memory and temporary files in tmpDir.
+ *
+ * BBWT is the sequence of the last characters of the conjugates of all Lyndon factors of the input, sorted
+ * in the omega-order (i.e. as infinite periodic strings). The Lyndon factorisation is streamed into a temporary
+ * file and the conjugates are sorted by prefix doubling: in every round the rank of each conjugate is combined
+ * with the rank of the conjugate shifted by h positions (within the same factor) and the pairs are sorted with
+ * external sorting. Both the rank file and the factor file are scanned sequentially. Sorting stops as soon as
+ * the ranks do not change any more (conjugates with equal ranks are then equal as infinite strings, so they
+ * have equal last characters), hence the number of rounds is logarithmic in the length of the longest common
+ * prefix of two distinct conjugates. The input file is memory-mapped and read sequentially.
+ *
+ * The cost is O(n log L) I/O volume, where L is the length of the longest common prefix of two distinct
+ * conjugates (up to log n rounds): every round writes and reads n pairs of ranks (24 bytes each) and n new
+ * ranks (16 bytes each) through two external sorts, and the sorts need further merge passes if the budget is
+ * too small to merge all runs at once. It is therefore much slower than bbwt() even when the data fits into
+ * memory: with a 1 GiB budget, 16 MiB of random bytes (a few rounds) took about 22 s compared to about 4 s
+ * in memory, and 16 MiB of English text (long repeats, many rounds) took about 128 s compared to about 2.5 s.
+ * External induced sorting (with priority queues in place of the random bucket accesses of the induction)
+ * would reduce the I/O volume to that of a constant number of sorts per recursion level, but it is not
+ * implemented here.
+ *
+ * The result is the same as the result of bbwt() for the whole file.
+ *
+ * @param inPath the input file
+ * @param outPath the output file (created or truncated)
+ * @param memoryBudget the amount of memory used for sorting (at least MinExternalMemory bytes)
+ * @param tmpDir the directory of temporary files (TMPDIR or /tmp by default)
+ * @return 0 after successful computation, non-zero in case of any error
+ */
+inline int bbwtExternal(const char *inPath, const char *outPath, size_t memoryBudget, const char *tmpDir = nullptr) {
+    if (memoryBudget < MinExternalMemory)
+        return -1;
+
+    if (tmpDir == nullptr)
+        tmpDir = getenv("TMPDIR");
+
+    const std::string dir = (tmpDir != nullptr && *tmpDir != '\0') ? tmpDir : "/tmp";
+
+    // Two sorters are used at the same time (one is merged while the other one is filled)
+    // besides a few buffered readers and writers
+    const size_t blockBytes = std::min((size_t) 1 << 20, std::max((size_t) 1 << 12, memoryBudget / 64));
+    const size_t sorterBytes = (memoryBudget - 4 * blockBytes) / 2;
+
+    MappedFile input;
+
+    if (!input.openRead(inPath))
+        return -1;
+
+    const unsigned char *inStr = input.data();
+    const uint64_t len = input.size();
+    int outFd = open(outPath, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+
+    if (outFd < 0)
+        return -1;
+
+    RecordWriter<unsigned char> output(outFd, blockBytes);
+    bool ok = true;
+
+    try {
+        if (len <= 1) {
+            for (uint64_t i = 0; i < len; ++i)
+                output.write(inStr[i]);
+
+            ok = output.flush();
+            close(outFd);
+
+            return ok ? 0 : -1;
+        }
+
+        //--------------------------------------------------------------------------------------------------------------
+        // Stream the Lyndon factorisation into a file (the starting positions of all factors and the input length)
+        //--------------------------------------------------------------------------------------------------------------
+
+        TempFile factors(dir);
+        RecordWriter<uint64_t> factorWriter(factors.descriptor(), blockBytes);
+
+        forEachLyndonFactor(inStr, len, [&](uint64_t start) { factorWriter.write(start); });
+        factorWriter.write(len);
+        ok = factors.good() && factorWriter.flush();
+
+        //--------------------------------------------------------------------------------------------------------------
+        // The initial ranks of conjugates are their first characters
+        //--------------------------------------------------------------------------------------------------------------
+
+        std::unique_ptr<TempFile> ranks(new TempFile(dir));
+        RecordWriter<uint64_t> rankWriter(ranks->descriptor(), blockBytes);
+        bool seen[256] = {false};
+        uint64_t numRanks = 0;
+
+        for (uint64_t i = 0; i < len; ++i) {
+            rankWriter.write(inStr[i]);
+
+            if (!seen[inStr[i]]) {
+                seen[inStr[i]] = true;
+                ++numRanks;
+            }
+        }
+
+        ok = ok && ranks->good() && rankWriter.flush();
+
+        //--------------------------------------------------------------------------------------------------------------
+        // Prefix doubling until all ranks are distinct or do not change
+        //--------------------------------------------------------------------------------------------------------------
+
+        for (uint64_t h = 1; ok && numRanks < len; h *= 2) {
+            ExternalSorter<ExternalRankPair, ExternalRankPair::ByRanks> pairs(sorterBytes, blockBytes, dir);
+            RecordReader<uint64_t> factorReader(factors.descriptor(), blockBytes);
+            RecordReader<uint64_t> rankReader(ranks->descriptor(), blockBytes);
+            RecordReader<uint64_t> shiftedReader(ranks->descriptor(), blockBytes);
+            uint64_t fStart = 0, fEnd;
+
+            factorReader.next(fStart);
+
+            while (ok && factorReader.next(fEnd)) {
+                const uint64_t fLen = fEnd - fStart;
+                const uint64_t shift = h % fLen;
+
+                // The shifted conjugates wrap around the factor
+                shiftedReader.seek(fStart + shift);
+
+                for (uint64_t k = 0; ok && k < fLen; ++k) {
+                    ExternalRankPair pair;
+
+                    if (k == fLen - shift)
+                        shiftedReader.seek(fStart);
+
+                    pair.pos = fStart + k;
+                    ok = rankReader.next(pair.rank1) && shiftedReader.next(pair.rank2) && pairs.push(pair);
+                }
+
+                fStart = fEnd;
+            }
+
+            ok = ok && !factorReader.failed() && pairs.sort();
+
+            // Name the pairs and sort the new ranks by position
+            ExternalSorter<ExternalPosRank, ExternalPosRank::ByPos> newRanks(sorterBytes, blockBytes, dir);
+            ExternalRankPair pair, prev = {0, 0, 0};
+            uint64_t numNewRanks = 0;
+
+            while (ok && pairs.next(pair)) {
+                if (numNewRanks == 0 || pair.rank1 != prev.rank1 || pair.rank2 != prev.rank2)
+                    ++numNewRanks;
+
+                ok = newRanks.push({pair.pos, numNewRanks - 1});
+                prev = pair;
+            }
+
+            ok = ok && !pairs.failed() && newRanks.sort();
+
+            std::unique_ptr<TempFile> nextRanks(new TempFile(dir));
+            RecordWriter<uint64_t> nextWriter(nextRanks->descriptor(), blockBytes);
+            ExternalPosRank posRank;
+
+            while (ok && newRanks.next(posRank))
+                nextWriter.write(posRank.rank);
+
+            ok = ok && !newRanks.failed() && nextRanks->good() && nextWriter.flush();
+            ranks.swap(nextRanks);
+
+            // The partition into ranks is stable, so it does not change in further rounds
+            if (numNewRanks == numRanks)
+                break;
+
+            numRanks = numNewRanks;
+        }
+
+        //--------------------------------------------------------------------------------------------------------------
+        // Sort the last characters of conjugates by the final ranks
+        //--------------------------------------------------------------------------------------------------------------
+
+        if (ok) {
+            ExternalSorter<ExternalRankChar, ExternalRankChar::ByRank> lastChars(sorterBytes, blockBytes, dir);
+            RecordReader<uint64_t> factorReader(factors.descriptor(), blockBytes);
+            RecordReader<uint64_t> rankReader(ranks->descriptor(), blockBytes);
+            uint64_t fStart = 0, fEnd;
+
+            factorReader.next(fStart);
+
+            while (ok && factorReader.next(fEnd)) {
+                for (uint64_t pos = fStart; ok && pos < fEnd; ++pos) {
+                    ExternalRankChar rankChar;
+
+                    // Wrap around the Lyndon factor if needed
+                    rankChar.c = inStr[(pos == fStart) ? fEnd - 1 : pos - 1];
+                    ok = rankReader.next(rankChar.rank) && lastChars.push(rankChar);
+                }
+
+                fStart = fEnd;
+            }
+
+            ok = ok && !factorReader.failed() && lastChars.sort();
+
+            ExternalRankChar rankChar;
+
+            while (ok && lastChars.next(rankChar))
+                output.write(rankChar.c);
+
+            ok = ok && !lastChars.failed() && output.flush();
+        }
+    }
+    catch (const std::bad_alloc &e) {
+        ok = false;
+    }
+
+    close(outFd);
+
+    return ok ? 0 : -1;
+}
+
+
+#endif //_BBWT_EXTERNAL_HPP_
@@ -0,0 +1,303 @@
+#ifndef _BBWT_INDEX_HPP_
+#define _BBWT_INDEX_HPP_
+
+/*
+ * FM-index style pattern search over the Bijective Burrows-Wheeler Transform.
+ *
+ * (c) 2023 Marcin Piątkowski, marcin.piatkowski(at)mat.umk.pl
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include <cstddef>
+#include <memory>
+#include <vector>
+
+#include "BitVector.hpp"
+#include "lyndon.hpp"
+#include "bbwt_alphabet.hpp"
+#include "bbwt_internal.hpp"
+
+
+/**
+ * Wavelet matrix over a sequence of symbols smaller than alphSize.
+ *
+ * Every level is a bit vector of a single bit of all symbols (from the most significant one), stably partitioned
+ * by the bits of the previous levels. Access and rank take O(log alphSize) rank queries on the bit vectors,
+ * and the structure takes about len * log(alphSize) bits.
+ */
+template<typename Tnum>
+class WaveletMatrix {
+public:
+    WaveletMatrix() = default;
+
+    /** Builds the matrix of str[0..len). Throws std::bad_alloc if out of memory. */
+    template<typename Tdata>
+    void build(const Tdata *str, Tnum len, Tnum alphSize) {
+        numLevels = 1;
+
+        while (((Tnum) 1 << numLevels) < alphSize)
+            ++numLevels;
+
+        levels.clear();
+        zeros.assign(numLevels, 0);
+
+        std::vector<Tdata> cur(str, str + len);
+        std::vector<Tdata> next(len);
+
+        for (int l = 0; l < numLevels; ++l) {
+            const int bit = numLevels - 1 - l;
+
+            levels.emplace_back(new BitVector<Tnum>(len));
+            BitVector<Tnum> &level = *levels.back();
+
+            for (Tnum i = 0; i < len; ++i) {
+                if ((cur[i] >> bit) & 1)
+                    level.set(i, true);
+                else
+                    ++zeros[l];
+            }
+
+            level.buildRankSelect();
+
+            // Symbols with bit 0 go first, then symbols with bit 1 (both in the original order)
+            Tnum zeroPos = 0, onePos = zeros[l];
+
+            for (Tnum i = 0; i < len; ++i)
+                next[((cur[i] >> bit) & 1) ? onePos++ : zeroPos++] = cur[i];
+
+            cur.swap(next);
+        }
+
+        // Occurrences of every symbol form a single block after the last level
+        starts.assign(alphSize, 0);
+
+        for (Tnum c = 0; c < alphSize; ++c)
+            starts[c] = mapPosition(c, 0);
+    }
+
+    /** The number of occurrences of c at positions [0, pos). */
+    inline Tnum rank(Tnum c, Tnum pos) const {
+        return mapPosition(c, pos) - starts[c];
+    }
+
+    /** Stores the symbol at position pos in c. @return The number of occurrences of c at positions [0, pos). */
+    Tnum inverseSelect(Tnum pos, Tnum &c) const {
+        c = 0;
+
+        for (int l = 0; l < numLevels; ++l) {
+            const BitVector<Tnum> &level = *levels[l];
+            Tnum ones = level.rank1(pos);
+
+            if (level[pos]) {
+                c |= (Tnum) 1 << (numLevels - 1 - l);
+                pos = zeros[l] + ones;
+            }
+            else {
+                pos -= ones;
+            }
+        }
+
+        return pos - starts[c];
+    }
+
+    /** The number of bytes allocated for the matrix (without rank directories). */
+    size_t memoryUsage() const {
+        size_t result = (zeros.capacity() + starts.capacity()) * sizeof(Tnum);
+
+        for (const auto &level : levels)
+            result += level->memoryUsage();
+
+        return result;
+    }
+
+private:
+    /** Follows position pos through all levels along the bits of c. */
+    Tnum mapPosition(Tnum c, Tnum pos) const {
+        for (int l = 0; l < numLevels; ++l) {
+            Tnum ones = levels[l]->rank1(pos);
+
+            if ((c >> (numLevels - 1 - l)) & 1)
+                pos = zeros[l] + ones;
+            else
+                pos -= ones;
+        }
+
+        return pos;
+    }
+
+    int numLevels = 0;
+    std::vector<std::unique_ptr<BitVector<Tnum>>> levels;
+    std::vector<Tnum> zeros;
+    std::vector<Tnum> starts;
+};
+
+
+/**
+ * Index over BBWT answering count and locate queries.
+ *
+ * Rows of BBWT are all conjugates of the Lyndon factors of the text in the omega-order, so backward search
+ * finds conjugates whose infinite powers start with the pattern, i.e. the occurrences of the pattern in the
+ * Lyndon factors read circularly (a pattern may wrap around the end of its factor, even many times).
+ * BBWT is stored in a wavelet matrix over its effective alphabet, together with the C array (see
+ * computeBucketsStructure()), so count takes O(m log sigma) time for a pattern of length m.
+ *
+ * For locate, the circular suffix array is sampled at every sampleRate-th text position and at the start of every
+ * Lyndon factor. The LF mapping moves from the conjugate starting at position p to the one starting at p - 1 (within
+ * the same factor), so every occurrence is reported after at most sampleRate - 1 steps.
+ */
+template<typename Tdata = unsigned char, typename Tnum = int>
+class BbwtIndex {
+public:
+    /**
+     * Builds the index. Throws std::bad_alloc if out of memory.
+     * @param inStr the text
+     * @param bbwtStr BBWT of the text
+     * @param csa circular suffix array of the text (e.g. computed by bbwt() into a different output buffer)
+     * @param len the size of the text
+     * @param sampleRate the distance between sampled text positions
+     */
+    template<typename Tsa>
+    BbwtIndex(const Tdata *inStr, const Tdata *bbwtStr, const Tsa *csa, Tnum len, Tnum sampleRate = 32)
+        : len(len), alphabet(bbwtStr, len) {
+        const Tnum alphSize = alphabet.size();
+
+        {
+            std::vector<Tdata> rankStr(len);
+
+            alphabet.encode(bbwtStr, rankStr.data(), len);
+
+            buckets.resize(alphSize + 1);
+            computeBucketsStructure(rankStr.data(), len, buckets.data(), alphSize);
+            symbols.build(rankStr.data(), len, alphSize);
+        }
+
+        BitVector<Tnum> lFac(len + 1);
+
+        lyndonFactors(inStr, len, &lFac);
+
+        sampled.reset(len);
+
+        for (Tnum row = 0; row < len; ++row) {
+            Tnum pos = csa[row];
+
+            if (pos % sampleRate == 0 || lFac[pos]) {
+                sampled.set(row, true);
+                samples.push_back(pos);
+            }
+        }
+
+        sampled.buildRankSelect();
+    }
+
+    /** Finds the rows of BBWT (i.e. the range [from, to)) of the conjugates starting with pattern[0..m).
+     * @return The number of occurrences of the pattern.
+     */
+    Tnum range(const Tdata *pattern, Tnum m, Tnum &from, Tnum &to) const {
+        from = 0;
+        to = len;
+
+        for (Tnum i = m - 1; i >= 0 && from < to; --i) {
+            Tdata c;
+
+            if (!alphabet.find(pattern[i], c)) {
+                from = to = 0;
+
+                break;
+            }
+
+            if (to - from == 1) {
+                // A single row only needs its own symbol (which is found along with its rank)
+                Tnum symbol;
+                Tnum rank = symbols.inverseSelect(from, symbol);
+
+                if (symbol != (Tnum) c) {
+                    from = to = 0;
+
+                    break;
+                }
+
+                from = buckets[c] + rank;
+                to = from + 1;
+            }
+            else {
+                from = buckets[c] + symbols.rank(c, from);
+                to = buckets[c] + symbols.rank(c, to);
+            }
+        }
+
+        return to - from;
+    }
+
+    /** @return The number of occurrences of pattern[0..m). */
+    inline Tnum count(const Tdata *pattern, Tnum m) const {
+        Tnum from, to;
+
+        return range(pattern, m, from, to);
+    }
+
+    /** Appends the starting positions of all occurrences of pattern[0..m) to positions (in no particular order).
+     * @return The number of occurrences of the pattern.
+     */
+    Tnum locate(const Tdata *pattern, Tnum m, std::vector<Tnum> &positions) const {
+        Tnum from, to;
+        Tnum result = range(pattern, m, from, to);
+
+        for (Tnum row = from; row < to; ++row)
+            positions.push_back(locateRow(row));
+
+        return result;
+    }
+
+    /** @return The starting position of the conjugate in the given row of BBWT. */
+    Tnum locateRow(Tnum row) const {
+        Tnum steps = 0;
+
+        while (!sampled[row]) {
+            Tnum c;
+            Tnum rank = symbols.inverseSelect(row, c);
+
+            row = buckets[c] + rank;
+            ++steps;
+        }
+
+        return samples[sampled.rank1(row)] + steps;
+    }
+
+    /** The length of the indexed text. */
+    inline Tnum size() const {
+        return len;
+    }
+
+    /** The number of bytes allocated for the index. */
+    size_t memoryUsage() const {
+        return symbols.memoryUsage() + sampled.memoryUsage() + (buckets.capacity() + samples.capacity()) * sizeof(Tnum);
+    }
+
+private:
+    const Tnum len;
+    EffectiveAlphabet<Tdata> alphabet;
+    WaveletMatrix<Tnum> symbols;
+    std::vector<Tnum> buckets;
+    BitVector<Tnum> sampled{0};
+    std::vector<Tnum> samples;
+};
+
+
+#endif //_BBWT_INDEX_HPP_
@@ -26,17 +26,33 @@
  */
 
 #include <new>
+#include <algorithm>
+#include <array>
+#include <atomic>
 #include <limits>
+#include <optional>
+#include <utility>
 #include <vector>
 
 #include "BitVector.hpp"
+#include "ThreadTeam.hpp"
 #include "lyndon.hpp"
+#include "bbwt_simd.hpp"
+#include "bbwt_stats.hpp"
+#include "bbwt_workspace.hpp"
 
 
 //-------------------------------------------------------------------------------------------------
 // Buckets
 //-------------------------------------------------------------------------------------------------
 
+/** The number of buckets used for byte alphabets, whatever the actual alphabet size is. */
+const int ByteAlphabetSize = 256;
+
+/** The longest input that can be indexed with int (a few positions past the end of the input are addressed as well). */
+const size_t MaxIntLength = (size_t) std::numeric_limits<int>::max() - 64;
+
+
 /**
  * Computes computes begins and ends of all buckets related to inData.
  *
@@ -49,18 +65,28 @@
  */
 template<typename Tdata, typename Tnum>
 void computeBucketsStructure(const Tdata *inData, const Tnum len, Tnum *buckets, const Tnum alphSize = 256) {
-    std::vector<Tnum> charCount(alphSize, 0);
-    Tnum total = 0;
-
-    for (Tnum i=0; i<len; ++i) {
-        ++charCount[inData[i]];
+    // Count characters directly in the buckets structure (buckets[c+1] is the number of characters c)
+    for (Tnum i=0; i<=alphSize; ++i) {
+        buckets[i] = 0;
     }
 
-    buckets[0] = 0;
+    if constexpr (sizeof(Tdata) == 1 && std::is_unsigned<Tdata>::value) {
+        Tnum counts[256] = {};
+
+        countBytes(inData, len, counts);
+
+        for (Tnum c=0; c<alphSize && c<256; ++c) {
+            buckets[c + 1] = counts[c];
+        }
+    }
+    else {
+        for (Tnum i=0; i<len; ++i) {
+            ++buckets[inData[i] + 1];
+        }
+    }
 
     for (Tnum i=0; i<alphSize; ++i) {
-        total += charCount[i];
-        buckets[i+1] = total;
+        buckets[i+1] += buckets[i];
     }
 }
 
@@ -87,11 +113,326 @@ bool isSingleton(const Tnum pos, const BitVector<Tnum> & lFac) {
 }
 
 
+/**
+ * Marks the positions of S type inf-suffixes in suffType and the starting positions of special Lyndon factors
+ * (i.e. the factors without S type positions, except for the forced one at its start) in spcSuff.
+ *
+ * Both vectors are filled a 64-bit word at a time, starting from the end of inStr. The comparisons of adjacent
+ * symbols are obtained as bitmasks from compareAdjacent() and the types of all positions of the word are resolved
+ * at once with propagateDown(). The last position of each Lyndon factor is of type L and its first position
+ * is always marked as type S.
+ */
+template<typename Tdata, typename Tnum>
+void classifySuffixes(const Tdata *inStr, Tnum len, const BitVector<Tnum> &lbFac, BitVector<Tnum> &suffType, BitVector<Tnum> &spcSuff) {
+    bool carry = false;     // The type of the first position of the next word
+    Tnum nextS = len;       // The first S type position after the current word
+    Tnum nextStart = len;   // The first Lyndon factor starting after the current position
+
+    for (Tnum w = (len - 1) >> 6; w >= 0; --w) {
+        Tnum base = w << 6;
+        Tnum count = std::min<Tnum>(64, len - 1 - base);
+        uint64_t valid = (len - base >= 64) ? ~uint64_t(0) : (uint64_t(1) << (len - base)) - 1;
+        uint64_t lt = 0, eq = 0;
+
+        if (count > 0)
+            compareAdjacent(inStr + base, count, lt, eq);
+
+        // The type of the last position of a factor does not depend on the symbols that follow it
+        uint64_t starts = lbFac.word(w);
+        uint64_t last = (starts >> 1) | (lbFac.word(w + 1) << 63);
+        uint64_t types = propagateDown(lt & ~last, eq & ~last, carry);
+
+        carry = types & 1;
+        starts &= valid;
+
+        // A factor is special if its first S type position (if any) is located after its end
+        for (uint64_t s = starts; s != 0; s &= ~(uint64_t(1) << (63 - __builtin_clzll(s)))) {
+            int bit = 63 - __builtin_clzll(s);
+            uint64_t above = types >> bit;
+            Tnum firstS = (above != 0) ? base + bit + __builtin_ctzll(above) : nextS;
+
+            if (firstS >= nextStart)
+                spcSuff.set(base + bit, true);
+
+            nextStart = base + bit;
+        }
+
+        if (types != 0)
+            nextS = base + __builtin_ctzll(types);
+
+        suffType.setWord(w, types | starts);
+    }
+}
+
+
+/**
+ * Calls visit(pos) for each LMS position (in the increasing order) which is not a start of a special factor.
+ * LMS positions are found with bitwise operations on whole words of the bit vectors.
+ */
+template<typename Tnum, typename Tvisit>
+void forEachLMSPos(Tnum len, const BitVector<Tnum> &lbFac, const BitVector<Tnum> &suffType, const BitVector<Tnum> &spcSuff, Tvisit visit) {
+    uint64_t prevTypes = 0;
+
+    for (Tnum w = 0, base = 0; base < len; ++w, base += 64) {
+        uint64_t types = suffType.word(w);
+        uint64_t lms = (lbFac.word(w) | (types & ~((types << 1) | (prevTypes >> 63)))) & ~spcSuff.word(w);
+
+        if (len - base < 64)
+            lms &= (uint64_t(1) << (len - base)) - 1;
+
+        prevTypes = types;
+
+        for (; lms != 0; lms &= lms - 1)
+            visit(base + __builtin_ctzll(lms));
+    }
+}
+
+
+//-------------------------------------------------------------------------------------------------
+// Parallel induced sorting
+//-------------------------------------------------------------------------------------------------
+
+/** Inputs (at any recursion level) shorter than this are always induced on a single thread. */
+const long MinParallelInductionLength = 1L << 20;
+
+/** The number of suffix array entries prepared by a single thread within one block of a parallel scan. */
+const long ParallelInductionBlock = 1L << 16;
+
+/**
+ * Single-threaded scans prefetch the input symbol and the words of lFac and suffType needed by the entry
+ * located this many positions ahead, so that the random accesses of consecutive entries overlap.
+ */
+const long InductionPrefetchDistance = 64;
+
+
+/** Returns the position preceding pos in its Lyndon factor (wrapping around the factor if needed). */
+template<typename Tnum>
+inline Tnum precedingPos(Tnum pos, const BitVector<Tnum> &lFac) {
+    return (lFac[pos] == 0) ? pos - 1 : lFac.next(pos) - 1;
+}
+
+
+/** Prefetches the data needed to induce a suffix from the entry j of sa (if it is a valid position). */
+template<typename Tdata, typename Tnum>
+inline void prefetchInduction(const Tdata *inStr, Tnum len, Tnum j, const BitVector<Tnum> &lFac, const BitVector<Tnum> &suffType) {
+    if (j > 0 && j < len) {
+        __builtin_prefetch(inStr + j - 1);
+        lFac.prefetch(j);
+        suffType.prefetch(j - 1);
+    }
+}
+
+
+/** BBWT emitter of circularSuffixArray() which discards all symbols, i.e. only the circular suffix array is computed. */
+struct NoBwtEmitter {
+    template<typename Tnum>
+    void operator()(Tnum, Tnum) const { }
+};
+
+
+/** Returns the L inf-suffix induced by the suffix j (or -1 if none) and stores its first character in c. */
+template<typename Tdata, typename Tnum>
+inline Tnum inducedSuffixL(const Tdata *inStr, Tnum j, const BitVector<Tnum> &lFac, const BitVector<Tnum> &suffType, Tnum &c) {
+    j = precedingPos(j, lFac);
+
+    if (suffType[j] != LType)
+        return -1;
+
+    c = inStr[j];
+
+    return j;
+}
+
+
+/** Returns the S inf-suffix induced by the suffix j (or -1 if none) and stores its first character in c. */
+template<typename Tdata, typename Tnum>
+inline Tnum inducedSuffixS(const Tdata *inStr, Tnum j, const BitVector<Tnum> &lFac, const BitVector<Tnum> &suffType, Tnum &c) {
+    if (lFac[j] != 0 || suffType[j - 1] != SType)
+        return -1;
+
+    c = inStr[j - 1];
+
+    return j - 1;
+}
+
+
+/*
+ * Parallel version of preSortSuffixexL.
+ * The suffix array is scanned in blocks, each of them in three steps:
+ * 1. all threads read the entries of the block and resolve the induced suffixes together with their first
+ *    characters (the random accesses to inStr, lFac and suffType),
+ * 2. the calling thread goes through the block in the scan order and assigns the target position of every induced
+ *    suffix from the buckets (touching only the block buffers and the buckets). Special factors are inserted here,
+ *    and suffixes induced into the block itself update its buffers, so the result is identical to the serial scan,
+ * 3. all threads store the induced suffixes into their target positions of sa.
+ * Only step 2 is serial, it is much cheaper than the other two but still limits the speedup for many threads.
+ */
+template<typename Tdata, typename Tnum, typename Tsa>
+int preSortSuffixexLParallel(const Tdata *inStr, Tsa *sa, Tnum len, const BitVector<Tnum> &lFac, const BitVector<Tnum> &suffType, const BitVector<Tnum> &spcFac, Tnum *buckets, ThreadTeam &team) {
+    const Tnum blockSize = ParallelInductionBlock * team.size();
+    std::vector<Tnum> seen(blockSize), induced(blockSize), chars(blockSize), target(blockSize);
+    std::vector<char> changed(blockSize);
+
+    Tnum p = spcFac.prev(len);
+
+    for (Tnum blockStart=0; blockStart<len; blockStart+=blockSize) {
+        Tnum blockEnd = std::min(len, blockStart + blockSize);
+
+        team.run([&](unsigned id, unsigned numThreads) {
+            Tnum part = (blockEnd - blockStart + numThreads - 1) / numThreads;
+            Tnum from = blockStart + part * id;
+            Tnum to = std::min(blockEnd, from + part);
+
+            for (Tnum i=from; i<to; ++i) {
+                Tnum j = seen[i - blockStart] = sa[i];
+                induced[i - blockStart] = (j < 0) ? -1 : inducedSuffixL(inStr, j, lFac, suffType, chars[i - blockStart]);
+                changed[i - blockStart] = 0;
+            }
+        });
+
+        for (Tnum i=blockStart; i<blockEnd; ++i) {
+            Tnum k = i - blockStart;
+
+            while ( (p >= 0) && buckets[inStr[p]] == i) {
+                Tnum j = lFac.next(p) - 1;
+                Tnum t = buckets[inStr[j]]++;
+
+                sa[t] = j;
+
+                if (t < blockEnd) {
+                    seen[t - blockStart] = j;
+                    changed[t - blockStart] = 1;
+                }
+
+                p = spcFac.prev(p);
+            }
+
+            target[k] = -1;
+
+            Tnum j = seen[k];
+
+            if (j < 0) {
+                continue;
+            }
+
+            if (changed[k]) {
+                induced[k] = inducedSuffixL(inStr, j, lFac, suffType, chars[k]);
+            }
+
+            if (induced[k] >= 0) {
+                Tnum t = target[k] = buckets[chars[k]]++;
+
+                if (t < blockEnd) {
+                    seen[t - blockStart] = induced[k];
+                    changed[t - blockStart] = 1;
+                }
+            }
+        }
+
+        team.run([&](unsigned id, unsigned numThreads) {
+            Tnum part = (blockEnd - blockStart + numThreads - 1) / numThreads;
+            Tnum from = part * id;
+            Tnum to = std::min(blockEnd - blockStart, from + part);
+
+            for (Tnum k=from; k<to; ++k) {
+                if (target[k] >= 0)
+                    sa[target[k]] = induced[k];
+            }
+        });
+    }
+
+    return 0;
+}
+
+
+/*
+ * Parallel version of preSortSuffixesS (see preSortSuffixexLParallel).
+ * BBWT symbols of the block are emitted by all threads after its induced suffixes are stored.
+ */
+template<typename Tdata, typename Tnum, typename Tsa, typename Temit>
+int preSortSuffixesSParallel(const Tdata *inStr, Tsa *sa, Tnum len, const BitVector<Tnum> &lFac, const BitVector<Tnum> &suffType, Tnum *buckets, ThreadTeam &team, const Temit &emit) {
+    const Tnum blockSize = ParallelInductionBlock * team.size();
+    std::vector<Tnum> seen(blockSize), induced(blockSize), chars(blockSize), target(blockSize);
+    std::vector<char> changed(blockSize);
+
+    for (Tnum blockEnd=len; blockEnd>0; blockEnd-=blockSize) {
+        Tnum blockStart = std::max((Tnum) 0, blockEnd - blockSize);
+
+        team.run([&](unsigned id, unsigned numThreads) {
+            Tnum part = (blockEnd - blockStart + numThreads - 1) / numThreads;
+            Tnum from = blockStart + part * id;
+            Tnum to = std::min(blockEnd, from + part);
+
+            for (Tnum i=from; i<to; ++i) {
+                Tnum j = seen[i - blockStart] = sa[i];
+                induced[i - blockStart] = (j < 0) ? -1 : inducedSuffixS(inStr, j, lFac, suffType, chars[i - blockStart]);
+                changed[i - blockStart] = 0;
+            }
+        });
+
+        for (Tnum i=blockEnd-1; i>=blockStart; --i) {
+            Tnum k = i - blockStart;
+            Tnum j = seen[k];
+
+            target[k] = -1;
+
+            if (j < 0) {
+                continue;
+            }
+
+            if (changed[k]) {
+                induced[k] = inducedSuffixS(inStr, j, lFac, suffType, chars[k]);
+            }
+
+            if (induced[k] >= 0) {
+                Tnum t = target[k] = --buckets[chars[k] + 1];
+
+                if (t >= blockStart) {
+                    seen[t - blockStart] = induced[k];
+                    changed[t - blockStart] = 1;
+                }
+            }
+        }
+
+        team.run([&](unsigned id, unsigned numThreads) {
+            Tnum part = (blockEnd - blockStart + numThreads - 1) / numThreads;
+            Tnum from = part * id;
+            Tnum to = std::min(blockEnd - blockStart, from + part);
+
+            for (Tnum k=from; k<to; ++k) {
+                if (target[k] >= 0)
+                    sa[target[k]] = induced[k];
+            }
+        });
+
+        // All entries of the block are final now (the stored suffixes may overwrite the block itself)
+        if constexpr (!std::is_same<Temit, NoBwtEmitter>::value) {
+            team.run([&](unsigned id, unsigned numThreads) {
+                Tnum part = (blockEnd - blockStart + numThreads - 1) / numThreads;
+                Tnum from = part * id;
+                Tnum to = std::min(blockEnd - blockStart, from + part);
+
+                for (Tnum k=from; k<to; ++k) {
+                    if (seen[k] >= 0)
+                        emit(blockStart + k, precedingPos(seen[k], lFac));
+                }
+            });
+        }
+    }
+
+    return 0;
+}
+
+
 /*
  * Place all suffixes of type L at the beginning of corresponding bucket.
  */
-template<typename Tdata, typename Tnum>
-int preSortSuffixexL(const Tdata *inStr, Tnum *sa, Tnum len, const BitVector<Tnum> &lFac, const BitVector<Tnum> &suffType, const BitVector<Tnum> &spcFac, Tnum *buckets) {
+template<typename Tdata, typename Tnum, typename Tsa>
+int preSortSuffixexL(const Tdata *inStr, Tsa *sa, Tnum len, const BitVector<Tnum> &lFac, const BitVector<Tnum> &suffType, const BitVector<Tnum> &spcFac, Tnum *buckets, ThreadTeam *team = nullptr) {
+    if (team != nullptr && team->size() > 1 && len >= MinParallelInductionLength)
+        return preSortSuffixexLParallel(inStr, sa, len, lFac, suffType, spcFac, buckets, *team);
+
+    const Tnum Distance = InductionPrefetchDistance;
     Tnum p = spcFac.prev(len);
 
     for (Tnum i=0; i<len; ++i) {
@@ -102,21 +443,19 @@ int preSortSuffixexL(const Tdata *inStr, Tnum *sa, Tnum len, const BitVector<Tnu
             p = spcFac.prev(p);
         }
 
+        // Entries ahead may still change before they are scanned, so prefetching is only a hint
+        if (i + Distance < len)
+            prefetchInduction(inStr, len, (Tnum) sa[i + Distance], lFac, suffType);
+
         Tnum j = sa[i];
 
         if (j < 0) {
             continue;
         }
 
-        // Wrap around Lyndon factor if needed
-        if (lFac.get(j) == 0) {
-            --j;
-        }
-        else {
-            j = lFac.next(j) - 1;
-        }
+        j = precedingPos(j, lFac);
 
-        if (suffType.get(j) == LType) {
+        if (suffType[j] == LType) {
             sa[buckets[inStr[j]]] = j;
             ++buckets[inStr[j]];
         }
@@ -128,20 +467,34 @@ int preSortSuffixexL(const Tdata *inStr, Tnum *sa, Tnum len, const BitVector<Tnu
 
 /*
  * Place all suffixes of type S at the end of corresponding bucket.
+ * Every entry of sa is final when it is scanned, so emit(i, p) may be called with the position p preceding sa[i],
+ * i.e. the position of the i-th symbol of BBWT. The entry sa[i] is not read afterwards.
  */
-template<typename Tdata, typename Tnum>
-int preSortSuffixesS(const Tdata *inStr, Tnum *sa, Tnum len, const BitVector<Tnum> &lFac, const BitVector<Tnum> &suffType, Tnum *buckets) {
+template<typename Tdata, typename Tnum, typename Tsa, typename Temit = NoBwtEmitter>
+int preSortSuffixesS(const Tdata *inStr, Tsa *sa, Tnum len, const BitVector<Tnum> &lFac, const BitVector<Tnum> &suffType, Tnum *buckets, ThreadTeam *team = nullptr,
+                     const Temit &emit = Temit()) {
+    if (team != nullptr && team->size() > 1 && len >= MinParallelInductionLength)
+        return preSortSuffixesSParallel(inStr, sa, len, lFac, suffType, buckets, *team, emit);
+
+    const Tnum Distance = InductionPrefetchDistance;
+
     for (Tnum i=len-1; i>=0; --i) {
+        if (i >= Distance)
+            prefetchInduction(inStr, len, (Tnum) sa[i - Distance], lFac, suffType);
+
         Tnum j = sa[i];
 
         if (j < 0) {
             continue;
         }
 
-        if (lFac.get(j) == 0) {
+        if constexpr (!std::is_same<Temit, NoBwtEmitter>::value)
+            emit(i, precedingPos(j, lFac));
+
+        if (lFac[j] == 0) {
             --j;
 
-            if (suffType.get(j) == SType) {
+            if (suffType[j] == SType) {
                 --buckets[inStr[j] + 1];
                 sa[buckets[inStr[j] + 1]] = j;
             }
@@ -152,65 +505,88 @@ int preSortSuffixesS(const Tdata *inStr, Tnum *sa, Tnum len, const BitVector<Tnu
 }
 
 
-template<typename Tdata, typename Tnum>
-int circularSuffixArray(const Tdata *inStr, Tnum *sa, Tnum len, const BitVector<Tnum> &lbFac, const Tnum alphSize = 256) {
+/*
+ * Computes the circular suffix array of inStr for the given Lyndon factorisation lbFac.
+ * If a thread team is given, induced sorting of long inputs is done in parallel.
+ * If stats are given, every level of recursion is recorded (see BbwtStats).
+ * All buffers are taken from the workspace ws (a temporary workspace is used if none is given).
+ * If an emitter is given, BBWT is emitted during the final induction: emit(i, p) is called once for every row i,
+ * where inStr[p] is the i-th symbol of BBWT (see preSortSuffixesS).
+ */
+template<typename Tdata, typename Tnum, typename Tsa, typename Tstats = NoStats, typename Temit = NoBwtEmitter>
+int circularSuffixArray(const Tdata *inStr, Tsa *sa, Tnum len, const BitVector<Tnum> &lbFac, const Tnum alphSize = 256,
+                        ThreadTeam *team = nullptr, Tstats *stats = nullptr, BbwtWorkspace<Tnum> *ws = nullptr,
+                        const Temit &emit = Temit()) {
+
+    if (stats) {
+        stats->enterLevel(len);
+        stats->phase(BbwtPhase::Classification);
+    }
 
-    //------------------------------------------------------------------------------------------------------------------
-    // Mark each position (and corresponding suffix) in inStr as type S or L respectively.
-    // All suffixes are initially assumed to be of type L (0), therefore we need to mark type S (1) suffixes only.
-    //------------------------------------------------------------------------------------------------------------------
+    // Byte alphabets (i.e. the input data) are processed with the number of buckets known at compile time
+    // and the buckets on the stack, integer alphabets (e.g. the labels of reduced strings) use the workspace.
+    // Only the buckets avoid the heap: the bit vectors always come from the workspace, so without a reserved
+    // workspace even a short input allocates them (and the temporary workspace itself).
+    constexpr bool ByteAlphabet = (sizeof(Tdata) == 1);
+    const Tnum numBuckets = ByteAlphabet ? (Tnum) ByteAlphabetSize : alphSize;
 
-    BitVector<Tnum> suffType(len + 7);
-    BitVector<Tnum> spcSuff(len + 1);
+    std::conditional_t<ByteAlphabet, std::array<Tnum, ByteAlphabetSize + 1>, std::array<Tnum, 0>> byteBuckets, byteTmpBuckets;
 
-    for (Tnum fStart=0, fEnd; fStart<len; fStart=fEnd) {
-        fEnd = lbFac.next(fStart);
-        suffType.set(fStart, SType);
+    // The local workspace is created only if none is given, so a reused workspace makes no allocations
+    std::optional<BbwtWorkspace<Tnum>> localWs;
 
-        // Mark all suffixes of type S
-        for (Tnum j = fEnd - 2; j >= fStart; --j) {
-            if ((inStr[j] < inStr[j + 1]) || (inStr[j] == inStr[j + 1] && suffType.get(j + 1) == SType))
-                suffType.set(j, SType);
-        }
+    if (ws == nullptr)
+        ws = &localWs.emplace();
 
-        Tnum m = 0, c = 0, c0;
-        Tnum c1 = inStr[fEnd - 1];
+    BbwtLevelBuffers<Tnum> &buffers = ws->enterLevel();
 
-        for (Tnum i = fEnd - 2; i >= fStart; --i) {
-            if ((c0 = inStr[i]) < (c1 + c)) {
-                c = 1;
-            } 
-            else if (c != 0) {
-                m += 1;
-                c = 0;
-            }
-
-            c1 = c0;
+    try {
+        buffers.suffType.reset(len + 7);
+        buffers.spcSuff.reset(len + 1);
+        if constexpr (!ByteAlphabet) {
+            buffers.buckets.resize(numBuckets + 1);
+            buffers.tmpBuckets.resize(numBuckets + 1);
         }
+    }
+    catch (const std::bad_alloc &e) {
+        ws->leaveLevel();
 
-        if ((m == 0) && (c == 0)) {
-            spcSuff.set(fStart, true);
-        }
+        if (stats)
+            stats->leaveLevel();
+
+        return -1;
     }
 
+    //------------------------------------------------------------------------------------------------------------------
+    // Mark each position (and corresponding suffix) in inStr as type S or L respectively.
+    // All suffixes are initially assumed to be of type L (0), therefore we need to mark type S (1) suffixes only.
+    //------------------------------------------------------------------------------------------------------------------
+
+    BitVector<Tnum> &suffType = buffers.suffType;
+    BitVector<Tnum> &spcSuff = buffers.spcSuff;
+
+    if (stats)
+        stats->allocated(suffType.memoryUsage() + spcSuff.memoryUsage());
+
+    classifySuffixes(inStr, len, lbFac, suffType, spcSuff);
+
     spcSuff.set(len, true);
 
     //------------------------------------------------------------------------------------------------------------------
     // Compute bucket sizes for the input data
     //------------------------------------------------------------------------------------------------------------------
 
-    Tnum *buckets;
-    Tnum *tmpBuckets;
+    Tnum *buckets = ByteAlphabet ? byteBuckets.data() : buffers.buckets.data();
+    Tnum *tmpBuckets = ByteAlphabet ? byteTmpBuckets.data() : buffers.tmpBuckets.data();
 
-    try {
-        buckets = new Tnum[alphSize + 1];
-        tmpBuckets = new Tnum[alphSize + 1];
-    }
-    catch (const std::bad_alloc &e) {
-        return -1;
-    }
+    computeBucketsStructure(inStr, len, buckets, numBuckets);
 
-    computeBucketsStructure(inStr, len, buckets, alphSize);
+    if (stats) {
+        if constexpr (!ByteAlphabet)
+            stats->allocated(2 * (numBuckets + 1) * sizeof(Tnum));
+
+        stats->phase(BbwtPhase::PreSorting);
+    }
 
     // Initialise all suffixes as being not set in a proper order
     for (Tnum i=0; i<len; ++i) {
@@ -221,36 +597,37 @@ int circularSuffixArray(const Tdata *inStr, Tnum *sa, Tnum len, const BitVector<
     // Insert each LMS inf-suffix (except those of length 1) at the end of the corresponding bucket
     //------------------------------------------------------------------------------------------------------------------
 
-    memcpy(tmpBuckets, buckets, (alphSize+1)*sizeof(Tnum));
+    memcpy(tmpBuckets, buckets, (numBuckets+1)*sizeof(Tnum));
 
-    for (Tnum i=0; i<len; ++i) {
-        if (isLMSPos(i, lbFac, suffType) && !spcSuff.get(i)) {
-            sa[tmpBuckets[inStr[i]+1]-1] = i;
-            --tmpBuckets[inStr[i]+1];
-        }
-    }
+    forEachLMSPos(len, lbFac, suffType, spcSuff, [&](Tnum i) {
+        sa[tmpBuckets[inStr[i]+1]-1] = i;
+        --tmpBuckets[inStr[i]+1];
+    });
 
     //------------------------------------------------------------------------------------------------------------------
     // Insert L inf-suffixes into the proper bucket (starting from the beginning of the bucket)
     //------------------------------------------------------------------------------------------------------------------
-    memcpy(tmpBuckets, buckets, (alphSize+1)*sizeof(Tnum));
-    preSortSuffixexL(inStr, sa, len, lbFac, suffType, spcSuff, tmpBuckets);
+    memcpy(tmpBuckets, buckets, (numBuckets+1)*sizeof(Tnum));
+    preSortSuffixexL(inStr, sa, len, lbFac, suffType, spcSuff, tmpBuckets, team);
 
     //------------------------------------------------------------------------------------------------------------------
     // Insert S inf-suffixes into the proper bucket (starting from the bucket end)
     //------------------------------------------------------------------------------------------------------------------
-    memcpy(tmpBuckets, buckets, (alphSize+1)*sizeof(Tnum));
-    preSortSuffixesS(inStr, sa, len, lbFac, suffType, tmpBuckets);
+    memcpy(tmpBuckets, buckets, (numBuckets+1)*sizeof(Tnum));
+    preSortSuffixesS(inStr, sa, len, lbFac, suffType, tmpBuckets, team);
 
     //------------------------------------------------------------------------------------------------------------------
     // Compact all LMS inf-suffixes into the first positions in the suffix array and clear its remaining part
     // To reduce the space complexity we use the end of the suffix array buffer to store labels of LMS inf-suffixes
     //------------------------------------------------------------------------------------------------------------------
 
+    if (stats)
+        stats->phase(BbwtPhase::Naming);
+
     Tnum numLMSSuff = 0;
 
     for (Tnum i=0; i<len; ++i) {
-        if (isLMSPos(sa[i], lbFac, suffType) && !spcSuff.get(sa[i])) {
+        if (isLMSPos((Tnum) sa[i], lbFac, suffType) && !spcSuff.get(sa[i])) {
             sa[numLMSSuff] = sa[i];
             ++numLMSSuff;
         }
@@ -265,14 +642,6 @@ int circularSuffixArray(const Tdata *inStr, Tnum *sa, Tnum len, const BitVector<
     // (of the length at most half the length of the original string)
     //------------------------------------------------------------------------------------------------------------------
 
-    Tnum *labelBuff;
-    try {
-        labelBuff = new Tnum[numLMSSuff + 1];
-    }
-    catch (const std::bad_alloc &e) {
-        return -1;
-    }
-
     for (Tnum fStart=0, fEnd; fStart<len; fStart=fEnd) {
         fEnd = lbFac.next(fStart);
 
@@ -310,11 +679,7 @@ int circularSuffixArray(const Tdata *inStr, Tnum *sa, Tnum len, const BitVector<
         bool distinct = true;
 
         if (sbwrdLen == qLen) {
-            Tnum j = 0;
-
-            for (j = 0; (j < sbwrdLen) && (inStr[pos + j] == inStr[q + j]); ++j) { }
-
-            if(j == sbwrdLen) {
+            if (equalSymbols(inStr + pos, inStr + q, sbwrdLen)) {
                 distinct = false;
             }
         }
@@ -332,31 +697,55 @@ int circularSuffixArray(const Tdata *inStr, Tnum *sa, Tnum len, const BitVector<
     // If the labels of LMS inf-suffixes are not unique we need a recursive call to sort them properly
     //------------------------------------------------------------------------------------------------------------------
 
+    if (stats)
+        stats->labels(numLMSSuff, numLabels);
+
     if (numLabels < numLMSSuff) {
+        if (stats)
+            stats->phase(BbwtPhase::Recursion);
+
+        // The reduced string is stored at the end of the suffix array buffer (the recursive call uses only
+        // its first numLMSSuff entries), a separate buffer is needed only if both parts would overlap
+        const bool inPlace = 2 * numLMSSuff <= len;
+        std::vector<Tsa> redBuffer;
+
         // Derive the Lyndon factorisation of the reduced string from the Lyndon factorisation of the original string
-        BitVector<Tnum> redFactors(numLMSSuff + 1);
+        BitVector<Tnum> &redFactors = buffers.redFactors;
 
-        for (Tnum inPos=0, outPos=0; inPos < len; ++inPos) {
-            if (isLMSPos(inPos, lbFac, suffType) && !spcSuff.get(inPos)) {
-                redFactors.set(outPos, lbFac.get(inPos));
-                ++outPos;
-            }
+        try {
+            redFactors.reset(numLMSSuff + 1);
+
+            if (!inPlace)
+                redBuffer.resize(numLMSSuff);
         }
+        catch (const std::bad_alloc &e) {
+            ws->leaveLevel();
+
+            if (stats)
+                stats->leaveLevel();
+
+            return -1;
+        }
+
+        Tnum outPos = 0;
+
+        forEachLMSPos(len, lbFac, suffType, spcSuff, [&](Tnum inPos) {
+            redFactors.set(outPos, lbFac.get(inPos));
+            ++outPos;
+        });
 
         redFactors.set(numLMSSuff, true);
+        redFactors.buildRankSelect();
 
         //--------------------------------------------------------------------------------------------------------------
         // Encode the input string using labels for its LMS inf-suffixes to obtain the reduced version of the problem
         //--------------------------------------------------------------------------------------------------------------
-        Tnum *redStr;
+        Tsa *redStr = inPlace ? sa + len - numLMSSuff : redBuffer.data();
 
-        try {
-            redStr = new Tnum[numLMSSuff];
-        }
-        catch (const std::bad_alloc &e) {
-            return -1;
-        }
+        if (stats)
+            stats->allocated(redFactors.memoryUsage() + (inPlace ? 0 : numLMSSuff * sizeof(Tsa)));
 
+        // Labels are moved towards the end of the buffer, so no label is overwritten before it is read
         for (Tnum inPos=len-1, outPos=numLMSSuff-1; inPos>=numLMSSuff; --inPos) {
             if (sa[inPos] !=0) {
                 redStr[outPos] = sa[inPos] - 1;
@@ -367,28 +756,36 @@ int circularSuffixArray(const Tdata *inStr, Tnum *sa, Tnum len, const BitVector<
         //--------------------------------------------------------------------------------------------------------------
         // Compute circular suffix array of the encoded string
         //--------------------------------------------------------------------------------------------------------------
-        circularSuffixArray(redStr, sa, numLMSSuff, redFactors, numLabels);
+        if (circularSuffixArray(redStr, sa, numLMSSuff, redFactors, numLabels, team, stats, ws) != 0) {
+            ws->leaveLevel();
 
+            if (stats)
+                stats->leaveLevel();
 
-        for (Tnum inPos=0, outPos=0; inPos<len; ++inPos) {
-            if (isLMSPos(inPos, lbFac, suffType) && !spcSuff.get(inPos)) {
-                redStr[outPos] = inPos;
-                ++outPos;
-            }
+            return -1;
         }
 
+
+        outPos = 0;
+
+        forEachLMSPos(len, lbFac, suffType, spcSuff, [&](Tnum inPos) {
+            redStr[outPos] = inPos;
+            ++outPos;
+        });
+
         for (Tnum i=0; i<numLMSSuff; ++i) {
             sa[i] = redStr[sa[i]];
         }
-
-        delete[] redStr;
     }
 
     //------------------------------------------------------------------------------------------------------------------
     // Induce the result for the original problem
     //------------------------------------------------------------------------------------------------------------------
 
-    memcpy(tmpBuckets, buckets, alphSize*sizeof(Tnum));
+    if (stats)
+        stats->phase(BbwtPhase::Induction);
+
+    memcpy(tmpBuckets, buckets, numBuckets*sizeof(Tnum));
 
     for (Tnum i=numLMSSuff; i<len; ++i) {
         sa[i] = -1;
@@ -407,21 +804,391 @@ int circularSuffixArray(const Tdata *inStr, Tnum *sa, Tnum len, const BitVector<
     //---------------------------------------------------------------------------------------------
     // Insert L inf-suffixes into the proper bucket (starTdatag from the beginning of the bucket)
     //---------------------------------------------------------------------------------------------
-    memcpy(tmpBuckets, buckets, alphSize*sizeof(Tnum));
-    preSortSuffixexL(inStr, sa, len, lbFac, suffType, spcSuff, tmpBuckets);
+    memcpy(tmpBuckets, buckets, numBuckets*sizeof(Tnum));
+    preSortSuffixexL(inStr, sa, len, lbFac, suffType, spcSuff, tmpBuckets, team);
 
     //------------------------------------------------------------------------------------------------------------------
     // Insert S inf-suffixes into the proper bucket (starTdatag from the bucket end)
     //------------------------------------------------------------------------------------------------------------------
-    memcpy(tmpBuckets, buckets, alphSize*sizeof(Tnum));
-    preSortSuffixesS(inStr, sa, len, lbFac, suffType, tmpBuckets);
+    memcpy(tmpBuckets, buckets, numBuckets*sizeof(Tnum));
+    preSortSuffixesS(inStr, sa, len, lbFac, suffType, tmpBuckets, team, emit);
 
-    delete[] buckets;
-    delete[] tmpBuckets;
-    delete[] labelBuff;
+    ws->leaveLevel();
+
+    if (stats)
+        stats->leaveLevel();
 
     return 0;
 }
 
 
+/*
+ * Retrieves Bijective Burrows-Wheeler Transform of inStr from its circular suffix array csa.
+ * If the input and output buffer have a non-empty overlap csa is used as a temporary storage.
+ */
+template<typename Tdata, typename Tnum, typename Tsa>
+void bbwtFromCsa(const Tdata *inStr, Tdata *outStr, Tsa *csa, Tnum len, const BitVector<Tnum> &lFac) {
+    if (inStr > outStr + len || outStr > inStr + len) {
+        for (Tnum outPos = 0; outPos < len; ++outPos) {
+            Tnum inPos = precedingPos((Tnum) csa[outPos], lFac);
+
+            outStr[outPos] = inStr[inPos];
+        }
+    }
+    else {
+        for (Tnum outPos = 0; outPos < len; ++outPos) {
+            Tnum inPos = precedingPos((Tnum) csa[outPos], lFac);
+
+            csa[outPos] = inStr[inPos];
+        }
+
+        for (Tnum pos = 0; pos < len; ++pos) {
+            outStr[pos] = (Tdata) csa[pos];
+        }
+    }
+}
+
+
+//-------------------------------------------------------------------------------------------------
+// Inverse transform
+//-------------------------------------------------------------------------------------------------
+
+/** Permutations shorter than this are decoded one cycle at a time. */
+const long MinInterleavedDecodeLength = 1L << 16;
+
+/** Distance between consecutive segment starts (a power of 2). Every position p with p % SegmentStep == 0 starts a segment. */
+const long SegmentStep = 1L << 12;
+
+/** The number of segments traversed in lockstep. */
+const int DecodeLanes = 32;
+
+
+/*
+ * Computes the standard permutation of inStr, i.e. stdPerm[i] is the position of inStr[i] in the stably sorted inStr.
+ * Characters are counted by all threads of the team in separate parts of inStr, so each thread
+ * can fill its part of stdPerm independently.
+ */
+template<typename Tdata, typename Tnum>
+void computeStandardPermutation(const Tdata *inStr, Tnum *stdPerm, Tnum len, const Tnum alphSize, ThreadTeam &team) {
+    const unsigned numParts = team.size();
+    const Tnum partLen = (len + numParts - 1) / numParts;
+    std::vector<Tnum> charsBefore(numParts * alphSize, 0);
+
+    team.run([&](unsigned id, unsigned) {
+        Tnum *charsCount = &charsBefore[id * alphSize];
+        Tnum from = partLen * (Tnum) id;
+        Tnum to = std::min(len, from + partLen);
+
+        for (Tnum i=from; i<to; ++i)
+            ++charsCount[inStr[i]];
+    });
+
+    // The first position of each character in each part
+    for (Tnum c=0, total=0; c<alphSize; ++c) {
+        for (unsigned t=0; t<numParts; ++t) {
+            Tnum count = charsBefore[t * alphSize + c];
+            charsBefore[t * alphSize + c] = total;
+            total += count;
+        }
+    }
+
+    team.run([&](unsigned id, unsigned) {
+        Tnum *charsSeen = &charsBefore[id * alphSize];
+        Tnum from = partLen * (Tnum) id;
+        Tnum to = std::min(len, from + partLen);
+
+        for (Tnum i=from; i<to; ++i)
+            stdPerm[i] = charsSeen[inStr[i]]++;
+    });
+}
+
+
+/*
+ * Checks whether pos is the smallest element of its cycle of stdPerm, given that the cycle may be concurrently marked
+ * as visited by the thread which owns it (i.e. the one whose part of stdPerm contains the smallest element).
+ */
+template<typename Tnum>
+bool isSmallestInCycle(const Tnum *stdPerm, Tnum pos) {
+    for (Tnum p = __atomic_load_n(&stdPerm[pos], __ATOMIC_RELAXED); p != pos; p = __atomic_load_n(&stdPerm[p], __ATOMIC_RELAXED)) {
+        if (p < pos || p < 0)
+            return false;
+    }
+
+    return true;
+}
+
+
+/*
+ * Decodes the cycles of the standard permutation stdPerm the same way as unbbwt() does (cycles are ordered by their
+ * smallest element and each of them is written backwards starting from that element), hiding the memory latency
+ * by following many independent pointer chains in lockstep with software prefetching.
+ *
+ * Every cycle is cut into segments at positions divisible by SegmentStep. The first pass follows all segments
+ * (DecodeLanes at a time on every thread of the team) to find their lengths, successors and minima, marking visited
+ * entries of stdPerm as negative. The remaining (short) cycles are found by all threads in separate parts of stdPerm:
+ * each thread takes the cycles whose smallest element lies in its part and marks their starts in a bit vector.
+ * The output position of every cycle follows from the cycle lengths by a prefix sum over the parts, so both the
+ * segments and the short cycles are then followed again and written straight into their final positions.
+ * stdPerm is destroyed.
+ */
+template<typename Tdata, typename Tnum>
+void decodeCyclesInterleaved(const Tdata *inStr, Tdata *outStr, Tnum *stdPerm, Tnum len, ThreadTeam &team) {
+    const Tnum Mask = SegmentStep - 1;
+    const Tnum numSegs = (len + Mask) / SegmentStep;
+
+    std::vector<Tnum> segLen(numSegs), segNext(numSegs), segMin(numSegs), segMinOff(numSegs);
+
+    //------------------------------------------------------------------------------------------------------------------
+    // First pass: follow all segments in lockstep. Threads take segments one by one from a shared counter.
+    //------------------------------------------------------------------------------------------------------------------
+
+    std::atomic<Tnum> nextSeg(0);
+
+    team.run([&](unsigned, unsigned) {
+        Tnum lanePos[DecodeLanes], laneSeg[DecodeLanes], laneCnt[DecodeLanes];
+        int numActive = 0;
+        Tnum seg;
+
+        for (; numActive < DecodeLanes && (seg = nextSeg++) < numSegs; ++numActive) {
+            lanePos[numActive] = segMin[seg] = seg * SegmentStep;
+            laneSeg[numActive] = seg;
+            laneCnt[numActive] = segMinOff[seg] = 0;
+        }
+
+        while (numActive > 0) {
+            for (int l=0; l<numActive; ++l) {
+                Tnum p = lanePos[l];
+                Tnum q = stdPerm[p];
+
+                seg = laneSeg[l];
+                stdPerm[p] = ~q;
+
+                if (p < segMin[seg]) {
+                    segMin[seg] = p;
+                    segMinOff[seg] = laneCnt[l];
+                }
+
+                ++laneCnt[l];
+
+                if ((q & Mask) != 0) {
+                    lanePos[l] = q;
+                    __builtin_prefetch(&stdPerm[q], 1);
+                    continue;
+                }
+
+                // The segment ends where the next one starts
+                segLen[seg] = laneCnt[l];
+                segNext[seg] = q / SegmentStep;
+
+                if ((seg = nextSeg++) < numSegs) {
+                    lanePos[l] = segMin[seg] = seg * SegmentStep;
+                    laneSeg[l] = seg;
+                    laneCnt[l] = segMinOff[seg] = 0;
+                }
+                else {
+                    --numActive;
+                    lanePos[l] = lanePos[numActive];
+                    laneSeg[l] = laneSeg[numActive];
+                    laneCnt[l] = laneCnt[numActive];
+                    --l;
+                }
+            }
+        }
+    });
+
+    //------------------------------------------------------------------------------------------------------------------
+    // Group segments into (long) cycles and order them by their smallest elements
+    //------------------------------------------------------------------------------------------------------------------
+
+    struct LongCycle {
+        Tnum min;                               // the smallest element
+        Tnum minSeg;                            // the segment containing it
+        Tnum len;
+        Tnum shortBefore;                       // the length of short cycles of the same part with smaller minima
+    };
+
+    std::vector<LongCycle> cycles;
+    std::vector<bool> segSeen(numSegs, false);
+
+    for (Tnum seg=0; seg<numSegs; ++seg) {
+        if (segSeen[seg])
+            continue;
+
+        Tnum minSeg = seg;
+        Tnum cycleLen = 0;
+
+        for (Tnum s = seg; !segSeen[s]; s = segNext[s]) {
+            segSeen[s] = true;
+            cycleLen += segLen[s];
+
+            if (segMin[s] < segMin[minSeg])
+                minSeg = s;
+        }
+
+        cycles.push_back({segMin[minSeg], minSeg, cycleLen, 0});
+    }
+
+    std::sort(cycles.begin(), cycles.end(), [](const LongCycle &a, const LongCycle &b) { return a.min < b.min; });
+
+    //------------------------------------------------------------------------------------------------------------------
+    // Cycles without any segment start are not visited yet. Each thread takes the ones whose smallest element lies
+    // in its part of stdPerm (parts are whole words of cycleStart), so they are found in the order of their minima.
+    //------------------------------------------------------------------------------------------------------------------
+
+    const unsigned numParts = team.size();
+    const Tnum partLen = (((len + numParts - 1) / numParts) + 63) & ~(Tnum) 63;
+
+    BitVector<Tnum> cycleStart(len);
+    std::vector<Tnum> shortLen(numParts, 0);
+
+    team.run([&](unsigned id, unsigned) {
+        Tnum from = std::min(len, partLen * (Tnum) id);
+        Tnum to = std::min(len, from + partLen);
+        Tnum total = 0;
+
+        auto cycle = std::lower_bound(cycles.begin(), cycles.end(), from, [](const LongCycle &c, Tnum pos) { return c.min < pos; });
+
+        for (Tnum j=from; j<to; ++j) {
+            for (; cycle != cycles.end() && cycle->min <= j; ++cycle)
+                cycle->shortBefore = total;
+
+            // With a single part the first unvisited element of a cycle is always its smallest one.
+            // Other threads may mark entries of stdPerm as visited at the same time, so all accesses are atomic.
+            if (__atomic_load_n(&stdPerm[j], __ATOMIC_RELAXED) < 0 || (numParts > 1 && !isSmallestInCycle(stdPerm, j)))
+                continue;
+
+            Tnum p = j;
+
+            for (Tnum q; (q = __atomic_load_n(&stdPerm[p], __ATOMIC_RELAXED)) >= 0; p = q) {
+                __atomic_store_n(&stdPerm[p], ~q, __ATOMIC_RELAXED);
+                ++total;
+            }
+
+            cycleStart.set(j, true);
+        }
+
+        shortLen[id] = total;
+    });
+
+    //------------------------------------------------------------------------------------------------------------------
+    // Output offsets: all cycles are written from the end of outStr in the order of their smallest elements
+    //------------------------------------------------------------------------------------------------------------------
+
+    std::vector<Tnum> partBefore(numParts);     // the length of all cycles with minima in preceding parts
+    std::vector<Tnum> segOut(numSegs), segLo(numSegs), segHi(numSegs);
+    Tnum before = 0;
+    size_t c = 0;
+
+    for (unsigned t=0; t<numParts; ++t) {
+        Tnum to = std::min(len, partLen * (Tnum) (t + 1));
+        Tnum longBefore = 0;
+
+        partBefore[t] = before;
+
+        for (; c < cycles.size() && cycles[c].min < to; ++c) {
+            const LongCycle &cycle = cycles[c];
+
+            // Each segment is written backwards from segOut, wrapping from segLo to segHi (the range of its cycle)
+            Tnum cycleHi = len - 1 - (before + longBefore + cycle.shortBefore);
+            Tnum dist = (cycle.len - segMinOff[cycle.minSeg]) % cycle.len;
+            Tnum s = cycle.minSeg;
+
+            do {
+                segOut[s] = cycleHi - dist;
+                segLo[s] = cycleHi - cycle.len + 1;
+                segHi[s] = cycleHi;
+                dist = (dist + segLen[s]) % cycle.len;
+                s = segNext[s];
+            } while (s != cycle.minSeg);
+
+            longBefore += cycle.len;
+        }
+
+        before += longBefore + shortLen[t];
+    }
+
+    //------------------------------------------------------------------------------------------------------------------
+    // Second pass: follow all segments in lockstep again and write the characters to their final positions
+    //------------------------------------------------------------------------------------------------------------------
+
+    nextSeg = 0;
+
+    team.run([&](unsigned, unsigned) {
+        Tnum lanePos[DecodeLanes], laneCnt[DecodeLanes], laneOut[DecodeLanes], laneLo[DecodeLanes], laneHi[DecodeLanes];
+        int numActive = 0;
+        Tnum seg;
+
+        for (; numActive < DecodeLanes && (seg = nextSeg++) < numSegs; ++numActive) {
+            lanePos[numActive] = seg * SegmentStep;
+            laneCnt[numActive] = segLen[seg];
+            laneOut[numActive] = segOut[seg];
+            laneLo[numActive] = segLo[seg];
+            laneHi[numActive] = segHi[seg];
+        }
+
+        while (numActive > 0) {
+            for (int l=0; l<numActive; ++l) {
+                Tnum p = lanePos[l];
+                Tnum q = ~stdPerm[p];
+
+                outStr[laneOut[l]] = inStr[p];
+                laneOut[l] = (laneOut[l] == laneLo[l]) ? laneHi[l] : laneOut[l] - 1;
+
+                if (--laneCnt[l] > 0) {
+                    lanePos[l] = q;
+                    __builtin_prefetch(&stdPerm[q]);
+                    __builtin_prefetch(&inStr[q]);
+                    continue;
+                }
+
+                if ((seg = nextSeg++) < numSegs) {
+                    lanePos[l] = seg * SegmentStep;
+                    laneCnt[l] = segLen[seg];
+                    laneOut[l] = segOut[seg];
+                    laneLo[l] = segLo[seg];
+                    laneHi[l] = segHi[seg];
+                }
+                else {
+                    --numActive;
+                    lanePos[l] = lanePos[numActive];
+                    laneCnt[l] = laneCnt[numActive];
+                    laneOut[l] = laneOut[numActive];
+                    laneLo[l] = laneLo[numActive];
+                    laneHi[l] = laneHi[numActive];
+                    --l;
+                }
+            }
+        }
+    });
+
+    //------------------------------------------------------------------------------------------------------------------
+    // Short cycles are written by the threads which found them, skipping the long cycles of their parts
+    //------------------------------------------------------------------------------------------------------------------
+
+    team.run([&](unsigned id, unsigned) {
+        Tnum from = std::min(len, partLen * (Tnum) id);
+        Tnum to = std::min(len, from + partLen);
+        Tnum outPos = len - 1 - partBefore[id];
+
+        auto cycle = std::lower_bound(cycles.begin(), cycles.end(), from, [](const LongCycle &c, Tnum pos) { return c.min < pos; });
+
+        for (Tnum w = from >> 6; (w << 6) < to; ++w) {
+            for (uint64_t bits = cycleStart.word(w); bits != 0; bits &= bits - 1) {
+                Tnum j = (w << 6) + __builtin_ctzll(bits);
+
+                for (; cycle != cycles.end() && cycle->min < j; ++cycle)
+                    outPos -= cycle->len;
+
+                Tnum p = j;
+
+                do {
+                    outStr[outPos--] = inStr[p];
+                    p = ~stdPerm[p];
+                } while (p != j);
+            }
+        }
+    });
+}
+
+
 #endif //_BBWT_INTERNAL_HPP_
@@ -0,0 +1,293 @@
+#ifndef _BBWT_RECORDS_HPP_
+#define _BBWT_RECORDS_HPP_
+
+/*
+ * Bijective Burrows-Wheeler Transform of newline-delimited records.
+ *
+ * (c) 2023 Marcin Piątkowski, marcin.piatkowski(at)mat.umk.pl
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <cstddef>
+#include <functional>
+#include <limits>
+#include <vector>
+
+#include <poll.h>
+#include <unistd.h>
+
+#include "ThreadTeam.hpp"
+#include "bbwt_workspace.hpp"
+#include "bbwt.hpp"
+
+
+/**
+ * Buffers used by a single thread of BbwtRecordProcessor. They are reused across records and batches.
+ */
+template<typename Tnum = int>
+struct RecordWorkspace {
+    BbwtWorkspace<Tnum> transform;
+    std::vector<Tnum> csa;
+    std::vector<unsigned char> output;  // Output of all records of the current batch processed by the thread
+};
+
+
+/** Appends BBWT of the record to ws.output.
+ * @return 0 after successful computation, non-zero in case of any error
+ */
+template<typename Tnum>
+int bbwtRecord(const unsigned char *record, Tnum len, RecordWorkspace<Tnum> &ws) {
+    size_t offset = ws.output.size();
+
+    if (len == 0)
+        return 0;
+
+    try {
+        if (ws.csa.size() < (size_t) len)
+            ws.csa.resize(len);
+
+        ws.output.resize(offset + len);
+    }
+    catch (const std::bad_alloc &e) {
+        return -1;
+    }
+
+    return bbwt(record, ws.output.data() + offset, ws.csa.data(), len, ws.transform);
+}
+
+
+/** Appends the inverse of BBWT of the record to ws.output.
+ * @return 0 after successful computation, non-zero in case of any error
+ */
+template<typename Tnum>
+int unbbwtRecord(const unsigned char *record, Tnum len, RecordWorkspace<Tnum> &ws) {
+    size_t offset = ws.output.size();
+
+    if (len == 0)
+        return 0;
+
+    try {
+        ws.output.resize(offset + len);
+    }
+    catch (const std::bad_alloc &e) {
+        return -1;
+    }
+
+    return unbbwt(record, ws.output.data() + offset, len, ws.transform);
+}
+
+
+/**
+ * Batch processing of newline-delimited records (e.g. lines of text) of arbitrary length.
+ *
+ * The input is read in large chunks. All complete records of a chunk form a batch, which is split into
+ * contiguous ranges of (roughly) the same size, one for each thread of the pool. Each thread processes its
+ * records with its own workspace and collects the results in its own output buffer, then the buffers are
+ * written in order, so the output has the same order of records as the input. A record longer than the chunk
+ * size is handled by growing the input buffer.
+ *
+ * The line separator is not part of the record passed to the record function; it is copied to the output
+ * after the result of each record (the last record may have no separator). When no more input data is
+ * immediately available (e.g. for interactive input) the complete records read so far are processed
+ * at once, otherwise batches are filled up to the chunk size.
+ */
+template<typename Tnum = int>
+class BbwtRecordProcessor {
+public:
+    /** Processes the record of length len and appends the result to ws.output (returns non-zero on error). */
+    using RecordFunction = std::function<int(const unsigned char *record, Tnum len, RecordWorkspace<Tnum> &ws)>;
+
+    /**
+     * @param process the function applied to every record (e.g. bbwtRecord<int> or unbbwtRecord<int>)
+     * @param numThreads the number of threads used (0 means the number of hardware threads)
+     * @param chunkSize the number of bytes read at once
+     */
+    explicit BbwtRecordProcessor(RecordFunction process, unsigned numThreads = 0, size_t chunkSize = 1 << 22)
+        : process(std::move(process)), team(numThreads), workspaces(team.size()), chunkSize(std::max(chunkSize, (size_t) 1)) {
+    }
+
+    /** Processes all records read from inFd and writes the results to outFd.
+     * @return 0 after successful computation, -1 if any record cannot be processed or in case of I/O error
+     */
+    int run(int inFd = STDIN_FILENO, int outFd = STDOUT_FILENO) {
+        std::vector<unsigned char> input;
+        size_t used = 0;
+        bool eof = false;
+
+        try {
+            input.resize(chunkSize);
+        }
+        catch (const std::bad_alloc &e) {
+            return -1;
+        }
+
+        while (!eof || used > 0) {
+            //----------------------------------------------------------------------------------------------------------
+            // Read as much data as possible (at least one complete record unless the input ends)
+            //----------------------------------------------------------------------------------------------------------
+
+            size_t batchLen = 0;
+
+            while (!eof) {
+                if (used == input.size()) {
+                    if (batchLen > 0)
+                        break;
+
+                    // A single record fills the whole buffer
+                    try {
+                        input.resize(2 * input.size());
+                    }
+                    catch (const std::bad_alloc &e) {
+                        return -1;
+                    }
+                }
+
+                ssize_t count = read(inFd, input.data() + used, input.size() - used);
+
+                if (count < 0) {
+                    if (errno == EINTR)
+                        continue;
+
+                    return -1;
+                }
+
+                if (count == 0) {
+                    eof = true;
+                    break;
+                }
+
+                for (size_t pos = used + count; pos > used; --pos) {
+                    if (input[pos - 1] == '\n') {
+                        batchLen = pos;
+                        break;
+                    }
+                }
+
+                used += count;
+
+                if (batchLen > 0 && !dataAvailable(inFd))
+                    break;
+            }
+
+            if (eof)
+                batchLen = used;
+
+            //----------------------------------------------------------------------------------------------------------
+            // Process the batch and write the results
+            //----------------------------------------------------------------------------------------------------------
+
+            if (batchLen > 0 && (processBatch(input.data(), batchLen) != 0 || writeResults(outFd) != 0))
+                return -1;
+
+            std::copy(input.begin() + batchLen, input.begin() + used, input.begin());
+            used -= batchLen;
+        }
+
+        return 0;
+    }
+
+private:
+    static bool dataAvailable(int fd) {
+        struct pollfd request = {fd, POLLIN, 0};
+
+        return poll(&request, 1, 0) > 0;
+    }
+
+    /** Processes all records of data[0..len). */
+    int processBatch(const unsigned char *data, size_t len) {
+        std::atomic<bool> failed(false);
+
+        team.run([&](unsigned id, unsigned numThreads) {
+            RecordWorkspace<Tnum> &ws = workspaces[id];
+
+            ws.output.clear();
+
+            // The thread processes all records starting within its range
+            const unsigned char *end = data + len;
+            const unsigned char *pos = data + len * id / numThreads;
+            const unsigned char *rangeEnd = data + len * (id + 1) / numThreads;
+
+            if (pos > data) {
+                pos = std::find(pos - 1, end, '\n');
+                pos = (pos == end) ? end : pos + 1;
+            }
+
+            while (pos < rangeEnd && !failed) {
+                const unsigned char *recordEnd = std::find(pos, end, '\n');
+                size_t recordLen = recordEnd - pos;
+
+                if (recordLen > (size_t) std::numeric_limits<Tnum>::max() || process(pos, recordLen, ws) != 0) {
+                    failed = true;
+                    break;
+                }
+
+                if (recordEnd == end)
+                    break;
+
+                try {
+                    ws.output.push_back('\n');
+                }
+                catch (const std::bad_alloc &e) {
+                    failed = true;
+                    break;
+                }
+
+                pos = recordEnd + 1;
+            }
+        });
+
+        return failed ? -1 : 0;
+    }
+
+    /** Writes the outputs of all threads in order. */
+    int writeResults(int outFd) {
+        for (auto &ws : workspaces) {
+            const unsigned char *data = ws.output.data();
+            size_t len = ws.output.size();
+
+            while (len > 0) {
+                ssize_t count = write(outFd, data, len);
+
+                if (count < 0) {
+                    if (errno == EINTR)
+                        continue;
+
+                    return -1;
+                }
+
+                data += count;
+                len -= count;
+            }
+        }
+
+        return 0;
+    }
+
+    RecordFunction process;
+    ThreadTeam team;
+    std::vector<RecordWorkspace<Tnum>> workspaces;
+    const size_t chunkSize;
+};
+
+
+#endif //_BBWT_RECORDS_HPP_
@@ -0,0 +1,504 @@
+#ifndef _BBWT_RUNLENGTH_HPP_
+#define _BBWT_RUNLENGTH_HPP_
+
+/*
+ * Run-length encoded Bijective Burrows-Wheeler Transform computed in compressed space.
+ *
+ * (c) 2023 Marcin Piątkowski, marcin.piatkowski(at)mat.umk.pl
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include <algorithm>
+#include <cstddef>
+#include <new>
+#include <vector>
+
+#include "lyndon.hpp"
+
+
+/** A run of equal symbols. */
+template<typename Tdata, typename Tnum>
+struct BbwtRun {
+    Tdata symbol;
+    Tnum length;
+};
+
+
+/**
+ * Dynamic run-length encoded string supporting insertion of a symbol at any position and rank queries.
+ *
+ * Runs are stored in the leaves of a B+ tree, inner nodes keep the length and the number of occurrences of each
+ * symbol for every child, so both operations take O(log r) time (r is the number of runs). Memory usage is O(r)
+ * regardless of the length of the string.
+ */
+template<typename Tdata, typename Tnum>
+class DynamicRunString {
+public:
+    explicit DynamicRunString(Tnum alphSize = 256) : alphSize(alphSize), scratch(alphSize) {
+        root = new Leaf();
+    }
+
+    DynamicRunString(const DynamicRunString &) = delete;
+    DynamicRunString &operator=(const DynamicRunString &) = delete;
+
+    ~DynamicRunString() {
+        delete root;
+    }
+
+    /** The length of the string. */
+    inline Tnum size() const {
+        return length;
+    }
+
+    /** The number of occurrences of c in the first pos symbols. */
+    Tnum rank(Tdata c, Tnum pos) const {
+        const Node *node = root;
+        Tnum result = 0;
+
+        while (!node->leaf) {
+            const Inner *inner = (const Inner *) node;
+            const Tnum *count = inner->count(c);
+            int j = 0;
+
+            while (j < inner->num - 1 && pos >= inner->sizes[j]) {
+                pos -= inner->sizes[j];
+                result += count[j];
+                ++j;
+            }
+
+            node = inner->children[j];
+        }
+
+        const Leaf *leaf = (const Leaf *) node;
+
+        for (int i = 0; i < leaf->num && pos > 0; ++i) {
+            Tnum len = std::min(pos, leaf->lengths[i]);
+
+            if (leaf->symbols[i] == c)
+                result += len;
+
+            pos -= len;
+        }
+
+        return result;
+    }
+
+    /** Inserts c before position pos (0 <= pos <= size()). Throws std::bad_alloc if out of memory. */
+    void insert(Tnum pos, Tdata c) {
+        Node *right = insert(root, pos, c);
+
+        ++length;
+
+        if (right != nullptr) {
+            Inner *newRoot = new Inner(alphSize);
+
+            // The old root is the only child at first, so it covers the whole string (including the right part)
+            newRoot->children[0] = root;
+            newRoot->sizes[0] = length;
+            newRoot->num = 1;
+            totals(root, newRoot->counts.data(), Fanout + 1);
+            totals(right, scratch.data());
+
+            for (Tnum s = 0; s < alphSize; ++s)
+                newRoot->count(s)[0] += scratch[s];
+
+            root = newRoot;
+            insertChild(newRoot, 1, right);
+        }
+    }
+
+    /** Calls visit(symbol, length) for all maximal runs from left to right. */
+    template<typename Tvisit>
+    void forEachRun(Tvisit visit) const {
+        Tdata symbol = 0;
+        Tnum runLen = 0;
+
+        forEachLeaf(root, [&](const Leaf *leaf) {
+            for (int i = 0; i < leaf->num; ++i) {
+                // Runs at the boundaries of leaves are not merged when inserting
+                if (runLen > 0 && leaf->symbols[i] != symbol) {
+                    visit(symbol, runLen);
+                    runLen = 0;
+                }
+
+                symbol = leaf->symbols[i];
+                runLen += leaf->lengths[i];
+            }
+        });
+
+        if (runLen > 0)
+            visit(symbol, runLen);
+    }
+
+    /** The number of bytes allocated for the tree. */
+    size_t memoryUsage() const {
+        return numLeaves * sizeof(Leaf) + numInner * (sizeof(Inner) + (size_t) alphSize * (Fanout + 1) * sizeof(Tnum))
+               + scratch.capacity() * sizeof(Tnum);
+    }
+
+private:
+    static const int LeafRuns = 128;
+    static const int Fanout = 32;
+
+    struct Node {
+        explicit Node(bool leaf) : leaf(leaf) {}
+        virtual ~Node() = default;
+
+        const bool leaf;
+        int num = 0;      // The number of runs (leaves) or children (inner nodes)
+    };
+
+    struct Leaf : Node {
+        Leaf() : Node(true) {}
+
+        // Two extra runs, as splitting a run inside adds two of them before the leaf is split
+        Tdata symbols[LeafRuns + 2];
+        Tnum lengths[LeafRuns + 2];
+    };
+
+    struct Inner : Node {
+        explicit Inner(Tnum alphSize) : Node(false), counts((size_t) alphSize * (Fanout + 1), 0) {}
+
+        ~Inner() override {
+            for (int j = 0; j < this->num; ++j)
+                delete children[j];
+        }
+
+        inline Tnum *count(Tdata c) {
+            return counts.data() + (size_t) c * (Fanout + 1);
+        }
+
+        inline const Tnum *count(Tdata c) const {
+            return counts.data() + (size_t) c * (Fanout + 1);
+        }
+
+        Node *children[Fanout + 1];
+        Tnum sizes[Fanout + 1];
+        std::vector<Tnum> counts;   // The number of occurrences of each symbol in each child (symbol-major)
+    };
+
+    /** Inserts c at position pos of the subtree. @return The new right sibling if the node has been split. */
+    Node *insert(Node *node, Tnum pos, Tdata c) {
+        if (node->leaf)
+            return insertLeaf((Leaf *) node, pos, c);
+
+        Inner *inner = (Inner *) node;
+        int j = 0;
+
+        // Insert at the end of a child rather than at the beginning of the next one, so runs may be extended
+        while (j < inner->num - 1 && pos > inner->sizes[j]) {
+            pos -= inner->sizes[j];
+            ++j;
+        }
+
+        ++inner->sizes[j];
+        ++inner->count(c)[j];
+
+        Node *right = insert(inner->children[j], pos, c);
+
+        if (right == nullptr)
+            return nullptr;
+
+        insertChild(inner, j + 1, right);
+
+        return (inner->num > Fanout) ? splitInner(inner) : nullptr;
+    }
+
+    Node *insertLeaf(Leaf *leaf, Tnum pos, Tdata c) {
+        int i = 0;
+
+        while (i < leaf->num - 1 && pos > leaf->lengths[i]) {
+            pos -= leaf->lengths[i];
+            ++i;
+        }
+
+        if (leaf->num == 0) {
+            insertRuns(leaf, 0, 1);
+            leaf->symbols[0] = c;
+            leaf->lengths[0] = 1;
+        }
+        else if (leaf->symbols[i] == c) {
+            ++leaf->lengths[i];
+        }
+        else if (pos == 0) {
+            insertRuns(leaf, i, 1);
+            leaf->symbols[i] = c;
+            leaf->lengths[i] = 1;
+        }
+        else if (pos == leaf->lengths[i]) {
+            if (i + 1 < leaf->num && leaf->symbols[i + 1] == c) {
+                ++leaf->lengths[i + 1];
+            }
+            else {
+                insertRuns(leaf, i + 1, 1);
+                leaf->symbols[i + 1] = c;
+                leaf->lengths[i + 1] = 1;
+            }
+        }
+        else {
+            // Split the run around the new symbol
+            insertRuns(leaf, i + 1, 2);
+            leaf->symbols[i + 1] = c;
+            leaf->lengths[i + 1] = 1;
+            leaf->symbols[i + 2] = leaf->symbols[i];
+            leaf->lengths[i + 2] = leaf->lengths[i] - pos;
+            leaf->lengths[i] = pos;
+        }
+
+        if (leaf->num <= LeafRuns)
+            return nullptr;
+
+        Leaf *right = new Leaf();
+        int half = leaf->num / 2;
+
+        right->num = leaf->num - half;
+        std::copy(leaf->symbols + half, leaf->symbols + leaf->num, right->symbols);
+        std::copy(leaf->lengths + half, leaf->lengths + leaf->num, right->lengths);
+        leaf->num = half;
+        ++numLeaves;
+
+        return right;
+    }
+
+    static void insertRuns(Leaf *leaf, int at, int count) {
+        std::copy_backward(leaf->symbols + at, leaf->symbols + leaf->num, leaf->symbols + leaf->num + count);
+        std::copy_backward(leaf->lengths + at, leaf->lengths + leaf->num, leaf->lengths + leaf->num + count);
+        leaf->num += count;
+    }
+
+    /** Inserts child right at position at of inner, moving its length and symbol counts out of the left sibling. */
+    void insertChild(Inner *inner, int at, Node *right) {
+        Tnum rightSize = totals(right, scratch.data());
+
+        std::copy_backward(inner->children + at, inner->children + inner->num, inner->children + inner->num + 1);
+        std::copy_backward(inner->sizes + at, inner->sizes + inner->num, inner->sizes + inner->num + 1);
+
+        inner->children[at] = right;
+        inner->sizes[at] = rightSize;
+        inner->sizes[at - 1] -= rightSize;
+
+        for (Tnum s = 0; s < alphSize; ++s) {
+            Tnum *count = inner->count(s);
+
+            std::copy_backward(count + at, count + inner->num, count + inner->num + 1);
+            count[at] = scratch[s];
+            count[at - 1] -= scratch[s];
+        }
+
+        ++inner->num;
+    }
+
+    Inner *splitInner(Inner *inner) {
+        Inner *right = new Inner(alphSize);
+        int half = inner->num / 2;
+
+        right->num = inner->num - half;
+        std::copy(inner->children + half, inner->children + inner->num, right->children);
+        std::copy(inner->sizes + half, inner->sizes + inner->num, right->sizes);
+
+        for (Tnum s = 0; s < alphSize; ++s)
+            std::copy(inner->count(s) + half, inner->count(s) + inner->num, right->count(s));
+
+        inner->num = half;
+        ++numInner;
+
+        return right;
+    }
+
+    /** Stores the number of occurrences of each symbol in the subtree in counts[0], counts[stride], ...
+     * @return The length of the subtree.
+     */
+    Tnum totals(const Node *node, Tnum *counts, size_t stride = 1) const {
+        Tnum size = 0;
+
+        for (Tnum s = 0; s < alphSize; ++s)
+            counts[s * stride] = 0;
+
+        if (node->leaf) {
+            const Leaf *leaf = (const Leaf *) node;
+
+            for (int i = 0; i < leaf->num; ++i) {
+                counts[leaf->symbols[i] * stride] += leaf->lengths[i];
+                size += leaf->lengths[i];
+            }
+        }
+        else {
+            const Inner *inner = (const Inner *) node;
+
+            for (int j = 0; j < inner->num; ++j)
+                size += inner->sizes[j];
+
+            for (Tnum s = 0; s < alphSize; ++s) {
+                for (int j = 0; j < inner->num; ++j)
+                    counts[s * stride] += inner->count(s)[j];
+            }
+        }
+
+        return size;
+    }
+
+    template<typename Tvisit>
+    static void forEachLeaf(const Node *node, const Tvisit &visit) {
+        if (node->leaf) {
+            visit((const Leaf *) node);
+        }
+        else {
+            const Inner *inner = (const Inner *) node;
+
+            for (int j = 0; j < inner->num; ++j)
+                forEachLeaf(inner->children[j], visit);
+        }
+    }
+
+    const Tnum alphSize;
+    std::vector<Tnum> scratch;
+    Node *root;
+    Tnum length = 0;
+    size_t numLeaves = 1;
+    size_t numInner = 0;
+};
+
+
+/**
+ * Online construction of run-length encoded BBWT in space proportional to the number of its runs.
+ *
+ * BBWT is the sequence of the last symbols of all conjugates of all Lyndon factors sorted in the omega-order.
+ * Factors are added one by one in the order of the Lyndon factorisation (i.e. in non-increasing order), so the
+ * smallest conjugate of a new factor w is smaller than (or equal to) all conjugates already present and it is
+ * inserted at the front. All other conjugates are inserted from the last one, w[i..]w[..i) being the conjugate
+ * w[i]·(w[i+1..]w[..i+1)), at the position computed by the LF mapping from the position of the previous one.
+ * Each symbol costs a single rank query and a single insertion into DynamicRunString.
+ *
+ * The input is accessed only within the current Lyndon factor, so it may be e.g. a memory-mapped file much larger
+ * than the available memory.
+ */
+template<typename Tdata = unsigned char, typename Tnum = long>
+class RunLengthBbwtBuilder {
+public:
+    /** @param alphSize size of the alphabet (all symbols have to be smaller) */
+    explicit RunLengthBbwtBuilder(Tnum alphSize = 256) : alphSize(alphSize), bwt(alphSize), firstCounts(alphSize + 1, 0) {}
+
+    /** Adds Lyndon factor factor[0..len) (factors have to be added in the order of the Lyndon factorisation).
+     * Throws std::bad_alloc if out of memory.
+     */
+    void addFactor(const Tdata *factor, Tnum len) {
+        Tnum pos = 0;
+
+        bwt.insert(pos, factor[len - 1]);
+        addFirst(factor[0]);
+
+        for (Tnum i = len - 1; i > 0; --i) {
+            Tdata c = factor[i];
+
+            // The smallest conjugate is the only one not followed (in the text order) by any inserted conjugate,
+            // so it is not counted by rank()
+            pos = firstBefore(c) + bwt.rank(c, pos) + (c == factor[0]);
+
+            bwt.insert(pos, factor[i - 1]);
+            addFirst(c);
+        }
+    }
+
+    /** Calls visit(symbol, length) for all runs of BBWT of the factors added so far. */
+    template<typename Tvisit>
+    void forEachRun(Tvisit visit) const {
+        bwt.forEachRun(visit);
+    }
+
+    /** The length of BBWT of the factors added so far. */
+    inline Tnum size() const {
+        return bwt.size();
+    }
+
+    /** The number of bytes allocated by the builder. */
+    size_t memoryUsage() const {
+        return bwt.memoryUsage() + firstCounts.capacity() * sizeof(Tnum);
+    }
+
+private:
+    // Binary indexed tree counting the first symbols of all inserted conjugates
+
+    void addFirst(Tdata c) {
+        for (Tnum i = (Tnum) c + 1; i <= alphSize; i += i & -i)
+            ++firstCounts[i];
+    }
+
+    Tnum firstBefore(Tdata c) const {
+        Tnum result = 0;
+
+        for (Tnum i = c; i > 0; i -= i & -i)
+            result += firstCounts[i];
+
+        return result;
+    }
+
+    const Tnum alphSize;
+    DynamicRunString<Tdata, Tnum> bwt;
+    std::vector<Tnum> firstCounts;
+};
+
+
+/** Computes run-length encoded Bijective Burrows-Wheeler Transform of inStr with RunLengthBbwtBuilder.
+ * Working memory is proportional to the number of runs of BBWT, not to the length of the input.
+ * @param inStr input data buffer (all symbols smaller than alphSize)
+ * @param len the size of the input data
+ * @param runs the computed runs of BBWT (maximal, i.e. adjacent runs have different symbols)
+ * @param alphSize size of the alphabet
+ * @param memoryUsage if given, the peak working memory in bytes is stored
+ * @return 0 after successful computation, non-zero in case of any error
+ */
+template<typename Tdata, typename Tnum>
+int bbwtRunLength(const Tdata *inStr, Tnum len, std::vector<BbwtRun<Tdata, Tnum>> &runs, const Tnum alphSize = 256,
+                  size_t *memoryUsage = nullptr) {
+    runs.clear();
+
+    if (inStr == nullptr && len > 0)
+        return -1;
+
+    try {
+        RunLengthBbwtBuilder<Tdata, Tnum> builder(alphSize);
+        Tnum factorStart = 0;
+
+        forEachLyndonFactor(inStr, len, [&](Tnum start) {
+            if (start > factorStart)
+                builder.addFactor(inStr + factorStart, start - factorStart);
+
+            factorStart = start;
+        });
+
+        if (len > factorStart)
+            builder.addFactor(inStr + factorStart, len - factorStart);
+
+        if (memoryUsage)
+            *memoryUsage = builder.memoryUsage();
+
+        builder.forEachRun([&](Tdata symbol, Tnum length) {
+            runs.push_back({symbol, length});
+        });
+    }
+    catch (const std::bad_alloc &e) {
+        return -1;
+    }
+
+    return 0;
+}
+
+
+#endif //_BBWT_RUNLENGTH_HPP_
@@ -0,0 +1,314 @@
+#ifndef _BBWT_SIMD_HPP_
+#define _BBWT_SIMD_HPP_
+
+/*
+ * Vectorised kernels of circular suffix array construction.
+ *
+ * (c) 2023 Marcin Piątkowski, marcin.piatkowski(at)mat.umk.pl
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+
+#include <cstdint>
+#include <cstring>
+#include <type_traits>
+
+#if defined(__GNUC__) && defined(__SSE2__) && (defined(__x86_64__) || defined(__i386__))
+#include <immintrin.h>
+#define BBWT_SIMD_X86
+#endif
+
+
+/*
+ * The kernels work on 64 consecutive positions at a time and return their results as 64-bit masks
+ * (bit i refers to position i), so they fit the words of BitVector. SSE2 is used on every x86-64 machine,
+ * AVX2 is used if the processor supports it (detected at run time, so the default build stays portable)
+ * and any other platform or element type falls back to scalar code. The vector kernels are used for bytes
+ * and 32-bit integers, i.e. for the input string and for the reduced strings of the recursion.
+ */
+
+
+/** Returns "true" if AVX2 kernels may be used on the current processor. */
+inline bool simdHasAvx2() {
+#if defined(__AVX2__)
+    return true;
+#elif defined(BBWT_SIMD_X86)
+    static const bool avx2 = __builtin_cpu_supports("avx2");
+
+    return avx2;
+#else
+    return false;
+#endif
+}
+
+
+//-------------------------------------------------------------------------------------------------
+// Comparison of adjacent symbols
+//-------------------------------------------------------------------------------------------------
+
+#ifdef BBWT_SIMD_X86
+
+/** Sign bit flipped before signed comparisons of 32-bit lanes, so that unsigned lanes compare correctly. */
+template<typename Tdata>
+inline int simdBias32() {
+    return std::is_signed<Tdata>::value ? 0 : (int) 0x80000000U;
+}
+
+
+inline void compareAdjacentBytesSse2(const unsigned char *s, uint64_t &lt, uint64_t &eq) {
+    lt = eq = 0;
+
+    for (int k = 0; k < 64; k += 16) {
+        __m128i a = _mm_loadu_si128((const __m128i *) (s + k));
+        __m128i b = _mm_loadu_si128((const __m128i *) (s + k + 1));
+        __m128i e = _mm_cmpeq_epi8(a, b);
+        __m128i le = _mm_cmpeq_epi8(_mm_max_epu8(a, b), b);
+
+        eq |= uint64_t((uint32_t) _mm_movemask_epi8(e)) << k;
+        lt |= uint64_t((uint32_t) _mm_movemask_epi8(_mm_andnot_si128(e, le))) << k;
+    }
+}
+
+
+__attribute__((target("avx2")))
+inline void compareAdjacentBytesAvx2(const unsigned char *s, uint64_t &lt, uint64_t &eq) {
+    lt = eq = 0;
+
+    for (int k = 0; k < 64; k += 32) {
+        __m256i a = _mm256_loadu_si256((const __m256i *) (s + k));
+        __m256i b = _mm256_loadu_si256((const __m256i *) (s + k + 1));
+        __m256i e = _mm256_cmpeq_epi8(a, b);
+        __m256i le = _mm256_cmpeq_epi8(_mm256_max_epu8(a, b), b);
+
+        eq |= uint64_t((uint32_t) _mm256_movemask_epi8(e)) << k;
+        lt |= uint64_t((uint32_t) _mm256_movemask_epi8(_mm256_andnot_si256(e, le))) << k;
+    }
+}
+
+
+inline void compareAdjacentInts32Sse2(const int32_t *s, int bias, uint64_t &lt, uint64_t &eq) {
+    const __m128i flip = _mm_set1_epi32(bias);
+
+    lt = eq = 0;
+
+    for (int k = 0; k < 64; k += 4) {
+        __m128i a = _mm_xor_si128(_mm_loadu_si128((const __m128i *) (s + k)), flip);
+        __m128i b = _mm_xor_si128(_mm_loadu_si128((const __m128i *) (s + k + 1)), flip);
+
+        eq |= uint64_t((uint32_t) _mm_movemask_ps(_mm_castsi128_ps(_mm_cmpeq_epi32(a, b)))) << k;
+        lt |= uint64_t((uint32_t) _mm_movemask_ps(_mm_castsi128_ps(_mm_cmpgt_epi32(b, a)))) << k;
+    }
+}
+
+
+__attribute__((target("avx2")))
+inline void compareAdjacentInts32Avx2(const int32_t *s, int bias, uint64_t &lt, uint64_t &eq) {
+    const __m256i flip = _mm256_set1_epi32(bias);
+
+    lt = eq = 0;
+
+    for (int k = 0; k < 64; k += 8) {
+        __m256i a = _mm256_xor_si256(_mm256_loadu_si256((const __m256i *) (s + k)), flip);
+        __m256i b = _mm256_xor_si256(_mm256_loadu_si256((const __m256i *) (s + k + 1)), flip);
+
+        eq |= uint64_t((uint32_t) _mm256_movemask_ps(_mm256_castsi256_ps(_mm256_cmpeq_epi32(a, b)))) << k;
+        lt |= uint64_t((uint32_t) _mm256_movemask_ps(_mm256_castsi256_ps(_mm256_cmpgt_epi32(b, a)))) << k;
+    }
+}
+
+#endif //BBWT_SIMD_X86
+
+
+/**
+ * Compares s[i] with s[i+1] for i in [0, count), count <= 64, so s[0..count] has to be readable.
+ * Bit i of lt is set if s[i] < s[i+1] and bit i of eq is set if s[i] == s[i+1].
+ */
+template<typename Tdata, typename Tnum>
+inline void compareAdjacent(const Tdata *s, Tnum count, uint64_t &lt, uint64_t &eq) {
+#ifdef BBWT_SIMD_X86
+    if (count == 64) {
+        if constexpr (std::is_integral<Tdata>::value && std::is_unsigned<Tdata>::value && sizeof(Tdata) == 1) {
+            if (simdHasAvx2())
+                compareAdjacentBytesAvx2((const unsigned char *) s, lt, eq);
+            else
+                compareAdjacentBytesSse2((const unsigned char *) s, lt, eq);
+
+            return;
+        }
+
+        if constexpr (std::is_integral<Tdata>::value && sizeof(Tdata) == 4) {
+            if (simdHasAvx2())
+                compareAdjacentInts32Avx2((const int32_t *) s, simdBias32<Tdata>(), lt, eq);
+            else
+                compareAdjacentInts32Sse2((const int32_t *) s, simdBias32<Tdata>(), lt, eq);
+
+            return;
+        }
+    }
+#endif
+
+    lt = eq = 0;
+
+    for (Tnum i = 0; i < count; ++i) {
+        lt |= uint64_t(s[i] < s[i + 1]) << i;
+        eq |= uint64_t(s[i] == s[i + 1]) << i;
+    }
+}
+
+
+/**
+ * Resolves t[i] = g[i] | (p[i] & t[i+1]) for all 64 bits of a word at once, where t[64] = carry.
+ * The values are propagated downwards through runs of p in log(64) steps (parallel prefix).
+ */
+inline uint64_t propagateDown(uint64_t g, uint64_t p, bool carry) {
+    uint64_t t = g;
+
+    // The run of p at the top of the word takes the value of the next word
+    if (carry)
+        t |= (~p != 0) ? p & ~(~uint64_t(0) >> __builtin_clzll(~p)) : p;
+
+    for (int k = 1; k < 64; k <<= 1) {
+        t |= p & (t >> k);
+        p &= p >> k;
+    }
+
+    return t;
+}
+
+
+//-------------------------------------------------------------------------------------------------
+// Histogram
+//-------------------------------------------------------------------------------------------------
+
+/** The number of independent counters per symbol, so that runs of equal bytes do not serialise the increments. */
+const int HistogramLanes = 4;
+
+
+/** Adds the number of occurrences of each byte of inData[0..len) to counts[0..256). */
+template<typename Tdata, typename Tnum>
+void countBytes(const Tdata *inData, Tnum len, Tnum *counts) {
+    static_assert(sizeof(Tdata) == 1, "countBytes() counts single bytes");
+
+    // 32-bit counters are flushed before they may overflow
+    const Tnum Chunk = Tnum(1) << 30;
+    const unsigned char *data = (const unsigned char *) inData;
+    uint32_t lanes[HistogramLanes][256];
+
+    for (Tnum begin = 0; begin < len; begin += Chunk) {
+        Tnum end = (len - begin > Chunk) ? begin + Chunk : len;
+        Tnum i = begin;
+
+        memset(lanes, 0, sizeof(lanes));
+
+        for (; i + HistogramLanes <= end; i += HistogramLanes) {
+            ++lanes[0][data[i]];
+            ++lanes[1][data[i + 1]];
+            ++lanes[2][data[i + 2]];
+            ++lanes[3][data[i + 3]];
+        }
+
+        for (; i < end; ++i)
+            ++lanes[0][data[i]];
+
+        for (int c = 0; c < 256; ++c)
+            counts[c] += (Tnum) lanes[0][c] + lanes[1][c] + lanes[2][c] + lanes[3][c];
+    }
+}
+
+
+//-------------------------------------------------------------------------------------------------
+// Equality of substrings
+//-------------------------------------------------------------------------------------------------
+
+#ifdef BBWT_SIMD_X86
+
+/** Compares 32-byte blocks of a and b, returns the length of the equal prefix (a multiple of 32 or the first mismatch). */
+__attribute__((target("avx2")))
+inline size_t equalPrefixAvx2(const unsigned char *a, const unsigned char *b, size_t n) {
+    size_t i = 0;
+
+    for (; i + 32 <= n; i += 32) {
+        __m256i e = _mm256_cmpeq_epi8(_mm256_loadu_si256((const __m256i *) (a + i)),
+                                      _mm256_loadu_si256((const __m256i *) (b + i)));
+        uint32_t mask = ~(uint32_t) _mm256_movemask_epi8(e);
+
+        if (mask != 0)
+            return i + __builtin_ctz(mask);
+    }
+
+    return i;
+}
+
+
+/** Compares 16-byte blocks of a and b, returns the length of the equal prefix (a multiple of 16 or the first mismatch). */
+inline size_t equalPrefixSse2(const unsigned char *a, const unsigned char *b, size_t n) {
+    size_t i = 0;
+
+    for (; i + 16 <= n; i += 16) {
+        __m128i e = _mm_cmpeq_epi8(_mm_loadu_si128((const __m128i *) (a + i)), _mm_loadu_si128((const __m128i *) (b + i)));
+        uint32_t mask = ~(uint32_t) _mm_movemask_epi8(e) & 0xFFFF;
+
+        if (mask != 0)
+            return i + __builtin_ctz(mask);
+    }
+
+    return i;
+}
+
+#endif //BBWT_SIMD_X86
+
+
+/** Returns "true" if a[0..n) and b[0..n) are equal. */
+template<typename Tdata, typename Tnum>
+inline bool equalSymbols(const Tdata *a, const Tdata *b, Tnum n) {
+    if constexpr (std::has_unique_object_representations<Tdata>::value) {
+        // Equal symbols have equal bytes, so whole blocks of symbols are compared as bytes
+        const unsigned char *x = (const unsigned char *) a;
+        const unsigned char *y = (const unsigned char *) b;
+        size_t bytes = (size_t) n * sizeof(Tdata);
+        size_t i = 0;
+
+#ifdef BBWT_SIMD_X86
+        // Both prefixes stop at the first mismatch, which is then found by the scalar loop
+        if (bytes >= 32 && simdHasAvx2())
+            i = equalPrefixAvx2(x, y, bytes);
+
+        i += equalPrefixSse2(x + i, y + i, bytes - i);
+#endif
+
+        for (; i < bytes; ++i) {
+            if (x[i] != y[i])
+                return false;
+        }
+
+        return true;
+    }
+    else {
+        for (Tnum i = 0; i < n; ++i) {
+            if (a[i] != b[i])
+                return false;
+        }
+
+        return true;
+    }
+}
+
+
+#endif //_BBWT_SIMD_HPP_
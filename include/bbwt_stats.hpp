@@ -0,0 +1,185 @@
+#ifndef _BBWT_STATS_HPP_
+#define _BBWT_STATS_HPP_
+
+/*
+ * Instrumentation of Bijective Burrows-Wheeler Transform construction.
+ *
+ * (c) 2023 Marcin Piątkowski, marcin.piatkowski(at)mat.umk.pl
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include <chrono>
+#include <cstddef>
+#include <iomanip>
+#include <iostream>
+#include <vector>
+
+
+/** Phases of circular suffix array (and BBWT) construction. */
+enum class BbwtPhase {
+    AlphabetCompaction,   // Mapping the input to its effective alphabet (top level only)
+    LyndonFactorisation,  // Lyndon factorisation of the input (top level only)
+    Classification,       // Marking types of suffixes and special factors
+    PreSorting,           // Inserting LMS inf-suffixes and inducing L and S inf-suffixes
+    Naming,               // Compacting LMS inf-suffixes and computing their labels
+    Recursion,            // Building the reduced problem and solving it (including nested levels)
+    Induction,            // Final induction of the circular suffix array
+    Retrieval,            // Retrieving BBWT from the circular suffix array (top level only)
+    None
+};
+
+const int NumPhases = (int) BbwtPhase::None;
+
+const char *const PhaseNames[NumPhases] = {
+    "alphabet", "lyndon", "classification", "presorting", "naming", "recursion", "induction", "retrieval"
+};
+
+
+/**
+ * Disabled instrumentation (the default). All hooks are empty, so the calls are optimised away.
+ */
+struct NoStats {
+    inline void enterLevel(long) {}
+    inline void leaveLevel() {}
+    inline void phase(BbwtPhase) {}
+    inline void allocated(size_t) {}
+    inline void labels(long, long) {}
+    inline void endPhase() {}
+};
+
+
+/**
+ * Per-phase instrumentation of circularSuffixArray() and bbwt().
+ *
+ * Every level of recursion of induced sorting is recorded separately, together with the wall time
+ * of each phase, the number of bytes allocated, the number of LMS inf-suffixes and the number of
+ * distinct labels. The time of the Recursion phase includes all nested levels. Phases executed outside
+ * of induced sorting (Lyndon factorisation and BBWT retrieval) are recorded in the top-level fields.
+ */
+class BbwtStats {
+public:
+    struct Level {
+        int depth = 0;
+        long length = 0;
+        long numLMSSuff = 0;
+        long numLabels = 0;
+        size_t bytesAllocated = 0;
+        double time[NumPhases] = {0};
+    };
+
+    /** Levels in the order of recursion (level depth + 1 follows level depth). */
+    std::vector<Level> levels;
+
+    /** Time of the phases executed outside of induced sorting. */
+    double time[NumPhases] = {0};
+
+    /** Bytes allocated at all levels (including the Lyndon factorisation bit vectors). */
+    size_t bytesAllocated = 0;
+
+    void enterLevel(long length) {
+        Level level;
+
+        level.depth = frames.size() - 1;
+        level.length = length;
+        frames.push_back({(long) levels.size(), BbwtPhase::None, Clock::now()});
+        levels.push_back(level);
+    }
+
+    void leaveLevel() {
+        closePhase();
+        frames.pop_back();
+    }
+
+    void phase(BbwtPhase p) {
+        closePhase();
+        frames.back().phase = p;
+        frames.back().start = Clock::now();
+    }
+
+    void allocated(size_t bytes) {
+        bytesAllocated += bytes;
+
+        if (frames.back().level >= 0)
+            levels[frames.back().level].bytesAllocated += bytes;
+    }
+
+    void labels(long numLMSSuff, long numLabels) {
+        levels[frames.back().level].numLMSSuff = numLMSSuff;
+        levels[frames.back().level].numLabels = numLabels;
+    }
+
+    void endPhase() {
+        closePhase();
+    }
+
+    /** Prints the recorded statistics, one line per phase and one line per level. */
+    void report(std::ostream &out) const {
+        out << std::fixed << std::setprecision(6);
+
+        for (int p = 0; p < NumPhases; ++p) {
+            if (time[p] > 0)
+                out << PhaseNames[p] << " " << time[p] << " s" << std::endl;
+        }
+
+        for (const Level &level : levels) {
+            out << "level " << level.depth << ": length " << level.length << ", LMS " << level.numLMSSuff
+                << ", labels " << level.numLabels << ", allocated " << level.bytesAllocated << " B";
+
+            for (int p = 0; p < NumPhases; ++p) {
+                if (level.time[p] > 0)
+                    out << ", " << PhaseNames[p] << " " << level.time[p] << " s";
+            }
+
+            out << std::endl;
+        }
+
+        out << "allocated " << bytesAllocated << " B" << std::endl;
+    }
+
+private:
+    using Clock = std::chrono::steady_clock;
+
+    struct Frame {
+        long level;
+        BbwtPhase phase;
+        Clock::time_point start;
+    };
+
+    void closePhase() {
+        Frame &frame = frames.back();
+
+        if (frame.phase != BbwtPhase::None) {
+            double elapsed = std::chrono::duration<double>(Clock::now() - frame.start).count();
+
+            if (frame.level >= 0)
+                levels[frame.level].time[(int) frame.phase] += elapsed;
+            else
+                time[(int) frame.phase] += elapsed;
+        }
+
+        frame.phase = BbwtPhase::None;
+    }
+
+    /** Levels being processed, the bottom frame stands for the top level (outside of induced sorting). */
+    std::vector<Frame> frames = {{-1, BbwtPhase::None, Clock::now()}};
+};
+
+
+#endif //_BBWT_STATS_HPP_
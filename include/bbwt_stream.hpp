@@ -0,0 +1,243 @@
+#ifndef _BBWT_STREAM_HPP_
+#define _BBWT_STREAM_HPP_
+
+/*
+ * Streaming Bijective Burrows-Wheeler Transform.
+ *
+ * (c) 2023 Marcin Piątkowski, marcin.piatkowski(at)mat.umk.pl
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include <algorithm>
+#include <cstddef>
+#include <functional>
+#include <memory>
+#include <optional>
+#include <vector>
+
+#include "BitVector.hpp"
+#include "ThreadTeam.hpp"
+#include "lyndon.hpp"
+#include "bbwt_alphabet.hpp"
+#include "bbwt_internal.hpp"
+#include "bbwt_workspace.hpp"
+#include "bbwt.hpp"
+
+
+/**
+ * Incremental Bijective Burrows-Wheeler Transform.
+ *
+ * Data passed to write() is collected into blocks of blockSize characters. Every full block is transformed
+ * independently and handed over to the callback, the last (possibly shorter) block is emitted by finish().
+ * Since each block is transformed as a separate string, the output has the same length as the input and
+ * BbwtStreamDecoder with the same block size restores the original data without any additional framing.
+ *
+ * The encoder never holds more than a single block: memory usage is about blockSize * (sizeof(Tdata) + sizeof(Tnum))
+ * bytes plus the workspace of the transform, regardless of the total length of the stream. All buffers are
+ * allocated once, so with a single thread transforming subsequent blocks of bytes does not touch the heap
+ * (see BbwtWorkspace for the parallel code paths). By default wider symbols are mapped to their ranks in the effective
+ * alphabet of every block (see EffectiveAlphabet), which allocates temporary tables for each block.
+ */
+template<typename Tdata = unsigned char, typename Tnum = int>
+class BbwtStreamEncoder {
+public:
+    using BlockCallback = std::function<void(const Tdata *block, Tnum len)>;
+
+    /**
+     * @param blockSize the number of characters transformed at once
+     * @param onBlock called with every transformed block (the buffer is valid only during the call)
+     * @param alphSize size of the alphabet (0 means the effective alphabet of every block)
+     * @param numThreads the number of threads used for Lyndon factorisation and induced sorting (0 means the number of hardware threads)
+     */
+    BbwtStreamEncoder(Tnum blockSize, BlockCallback onBlock, const Tnum alphSize = 0, unsigned numThreads = 1)
+        : blockSize(blockSize), alphSize(alphSize), onBlock(std::move(onBlock)),
+          block(blockSize), csa(blockSize), ws(blockSize, (alphSize > 0) ? alphSize : ByteAlphabetSize) {
+        if (numThreads != 1)
+            team.reset(new ThreadTeam(numThreads));
+    }
+
+    /** Appends len characters to the stream. Every completed block is transformed and emitted.
+     * @return 0 after successful computation, non-zero in case of any error
+     */
+    int write(const Tdata *data, size_t len) {
+        while (len > 0) {
+            size_t chunk = std::min(len, (size_t) (blockSize - used));
+
+            std::copy(data, data + chunk, block.data() + used);
+            used += chunk;
+            data += chunk;
+            len -= chunk;
+
+            if (used == blockSize && flush() != 0)
+                return -1;
+        }
+
+        return 0;
+    }
+
+    /** Transforms and emits the last incomplete block. The encoder may be reused for the next stream afterwards.
+     * @return 0 after successful computation, non-zero in case of any error
+     */
+    int finish() {
+        return (used > 0) ? flush() : 0;
+    }
+
+private:
+    int flush() {
+        Tnum len = used;
+
+        used = 0;
+
+        if (len > 1) {
+            Tnum blockAlphSize = alphSize;
+            std::optional<EffectiveAlphabet<Tdata>> alphabet;
+
+            // Bytes are always sorted with buckets for all 256 values, wider symbols are ranked if needed
+            if (blockAlphSize == 0 && sizeof(Tdata) == 1) {
+                blockAlphSize = ByteAlphabetSize;
+            }
+            else if (blockAlphSize == 0) {
+                try {
+                    alphabet.emplace(block.data(), len);
+                }
+                catch (const std::bad_alloc &e) {
+                    return -1;
+                }
+
+                if (alphabet->isIdentity() || alphabet->isDirect()) {
+                    blockAlphSize = (Tnum) alphabet->maxSymbol() + 1;
+                    alphabet.reset();
+                }
+                else {
+                    alphabet->encode(block.data(), block.data(), len);
+                    blockAlphSize = (Tnum) alphabet->size();
+                }
+            }
+
+            ws.lFac.reset(len + 1);
+            lyndonFactors(block.data(), len, &ws.lFac, (BitVector<Tnum> *) nullptr, team ? team->size() : 1);
+            ws.lFac.buildRankSelect();
+
+            // The block is transformed in place, so its BBWT is emitted into csa and copied afterwards
+            auto emit = [this](Tnum row, Tnum pos) {
+                csa[row] = block[pos];
+            };
+
+            if (circularSuffixArray(block.data(), csa.data(), len, ws.lFac, blockAlphSize, team.get(), (NoStats *) nullptr, &ws, emit) != 0)
+                return -1;
+
+            std::copy(csa.begin(), csa.begin() + len, block.begin());
+
+            if (alphabet)
+                alphabet->decode(block.data(), block.data(), len);
+        }
+
+        onBlock(block.data(), len);
+
+        return 0;
+    }
+
+    const Tnum blockSize;
+    const Tnum alphSize;
+    BlockCallback onBlock;
+    std::vector<Tdata> block;
+    std::vector<Tnum> csa;
+    BbwtWorkspace<Tnum> ws;
+    std::unique_ptr<ThreadTeam> team;
+    Tnum used = 0;
+};
+
+
+/**
+ * Incremental inverse of Bijective Burrows-Wheeler Transform.
+ *
+ * Reverses BbwtStreamEncoder: the transformed stream is cut into blocks of blockSize characters (which must match
+ * the block size of the encoder), every full block is decoded and handed over to the callback, the last block
+ * is decoded by finish(). Memory usage is about blockSize * (2 * sizeof(Tdata) + sizeof(Tnum)) bytes.
+ * Blocks of at least MinInterleavedDecodeLength characters are decoded with temporary buffers allocated per block.
+ */
+template<typename Tdata = unsigned char, typename Tnum = int>
+class BbwtStreamDecoder {
+public:
+    using BlockCallback = std::function<void(const Tdata *block, Tnum len)>;
+
+    /**
+     * @param blockSize the block size used by the encoder
+     * @param onBlock called with every decoded block (the buffer is valid only during the call)
+     * @param alphSize size of the alphabet (0 means the effective alphabet of every block)
+     * @param numThreads the number of threads used (0 means the number of hardware threads)
+     */
+    BbwtStreamDecoder(Tnum blockSize, BlockCallback onBlock, const Tnum alphSize = 0, unsigned numThreads = 1)
+        : blockSize(blockSize), alphSize(alphSize), numThreads(numThreads), onBlock(std::move(onBlock)),
+          block(blockSize), decoded(blockSize), ws(blockSize, (alphSize > 0) ? alphSize : ByteAlphabetSize) {
+    }
+
+    /** Appends len transformed characters to the stream. Every completed block is decoded and emitted.
+     * @return 0 after successful computation, non-zero in case of any error
+     */
+    int write(const Tdata *data, size_t len) {
+        while (len > 0) {
+            size_t chunk = std::min(len, (size_t) (blockSize - used));
+
+            std::copy(data, data + chunk, block.data() + used);
+            used += chunk;
+            data += chunk;
+            len -= chunk;
+
+            if (used == blockSize && flush() != 0)
+                return -1;
+        }
+
+        return 0;
+    }
+
+    /** Decodes and emits the last incomplete block. The decoder may be reused for the next stream afterwards.
+     * @return 0 after successful computation, non-zero in case of any error
+     */
+    int finish() {
+        return (used > 0) ? flush() : 0;
+    }
+
+private:
+    int flush() {
+        Tnum len = used;
+
+        used = 0;
+
+        if (unbbwt(block.data(), decoded.data(), len, alphSize, numThreads, &ws) != 0)
+            return -1;
+
+        onBlock(decoded.data(), len);
+
+        return 0;
+    }
+
+    const Tnum blockSize;
+    const Tnum alphSize;
+    const unsigned numThreads;
+    BlockCallback onBlock;
+    std::vector<Tdata> block;
+    std::vector<Tdata> decoded;
+    BbwtWorkspace<Tnum> ws;
+    Tnum used = 0;
+};
+
+
+#endif //_BBWT_STREAM_HPP_
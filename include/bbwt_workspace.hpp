@@ -0,0 +1,143 @@
+#ifndef _BBWT_WORKSPACE_HPP_
+#define _BBWT_WORKSPACE_HPP_
+
+/*
+ * Reusable buffers for Bijective Burrows-Wheeler Transform computation.
+ *
+ * (c) 2023 Marcin Piątkowski, marcin.piatkowski(at)mat.umk.pl
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include <cstddef>
+#include <memory>
+#include <vector>
+
+#include "BitVector.hpp"
+
+
+/**
+ * Buffers used by a single level of recursion of induced sorting.
+ */
+template<typename Tnum>
+struct BbwtLevelBuffers {
+    BitVector<Tnum> suffType{0};
+    BitVector<Tnum> spcSuff{0};
+    BitVector<Tnum> redFactors{0};
+    std::vector<Tnum> buckets;
+    std::vector<Tnum> tmpBuckets;
+};
+
+
+/**
+ * Working memory of circularSuffixArray(), bbwt() and unbbwt() which may be reused across calls.
+ *
+ * Buffers are only grown, never shrunk, so after the workspace is reserved for the maximum input length
+ * (or after the longest input has been processed once) bbwt() and circularSuffixArray() on a single thread
+ * make no heap allocations. The parallel code paths of long inputs allocate their per-thread buffers on every call,
+ * and so does unbbwt() for inputs of at least MinInterleavedDecodeLength characters (even on a single thread).
+ */
+template<typename Tnum>
+class BbwtWorkspace {
+public:
+    /** Creates a workspace, optionally with all buffers reserved for inputs of up to maxLen characters. */
+    explicit BbwtWorkspace(Tnum maxLen = 0, Tnum alphSize = 256) {
+        reserve(maxLen, alphSize);
+    }
+
+    BbwtWorkspace(const BbwtWorkspace &) = delete;
+    BbwtWorkspace &operator=(const BbwtWorkspace &) = delete;
+
+    /** Reserves all buffers for inputs of up to maxLen characters. Throws std::bad_alloc if out of memory. */
+    void reserve(Tnum maxLen, Tnum alphSize = 256) {
+        lFac.reserve(maxLen + 1);
+        stdPerm.reserve(maxLen);
+        charsCount.reserve(alphSize);
+        charsBefore.reserve(alphSize);
+        charsSeen.reserve(alphSize);
+
+        // LMS inf-suffixes are at least two positions apart, so every level of recursion is at most half
+        // as long as the previous one and its alphabet (the labels) is not larger than its length
+        for (size_t depth = 0; maxLen > 1; ++depth) {
+            BbwtLevelBuffers<Tnum> &buffers = level(depth);
+            Tnum redLen = (maxLen + 1) / 2;
+
+            buffers.suffType.reserve(maxLen + 7);
+            buffers.spcSuff.reserve(maxLen + 1);
+            buffers.redFactors.reserve(redLen + 1);
+            buffers.buckets.reserve(alphSize + 1);
+            buffers.tmpBuckets.reserve(alphSize + 1);
+
+            maxLen = redLen;
+            alphSize = redLen;
+        }
+    }
+
+    /** Returns the buffers of the next level of recursion. */
+    BbwtLevelBuffers<Tnum> &enterLevel() {
+        return level(depth++);
+    }
+
+    void leaveLevel() {
+        --depth;
+    }
+
+    /** Returns the number of bytes held by all buffers, i.e. the high-water mark of all computations so far. */
+    size_t memoryUsage() const {
+        size_t bytes = lFac.memoryUsage()
+                       + (stdPerm.capacity() + charsCount.capacity() + charsBefore.capacity() + charsSeen.capacity()) * sizeof(Tnum);
+
+        for (const auto &buffers : levels) {
+            bytes += buffers->suffType.memoryUsage() + buffers->spcSuff.memoryUsage() + buffers->redFactors.memoryUsage();
+        }
+
+        return bytes + bucketsMemoryUsage();
+    }
+
+    /** Returns the number of bytes held by the buckets of all levels of recursion (included in memoryUsage()). */
+    size_t bucketsMemoryUsage() const {
+        size_t bytes = 0;
+
+        for (const auto &buffers : levels)
+            bytes += (buffers->buckets.capacity() + buffers->tmpBuckets.capacity()) * sizeof(Tnum);
+
+        return bytes;
+    }
+
+    BitVector<Tnum> lFac{0};
+
+    std::vector<Tnum> stdPerm;
+    std::vector<Tnum> charsCount;
+    std::vector<Tnum> charsBefore;
+    std::vector<Tnum> charsSeen;
+
+private:
+    BbwtLevelBuffers<Tnum> &level(size_t d) {
+        while (levels.size() <= d)
+            levels.emplace_back(new BbwtLevelBuffers<Tnum>());
+
+        return *levels[d];
+    }
+
+    std::vector<std::unique_ptr<BbwtLevelBuffers<Tnum>>> levels;
+    size_t depth = 0;
+};
+
+
+#endif //_BBWT_WORKSPACE_HPP_
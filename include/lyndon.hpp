@@ -26,55 +26,260 @@
  */
 
 
+#include <algorithm>
+#include <memory>
+#include <thread>
+#include <vector>
+
 #include "BitVector.hpp"
 
 
-/** Lyndon factorisation based on Duval's algorithm.
- *
- * @param inStr Input data.
- * @param factors BitVector os size (length + 1).
- *        Starting position of each Lyndon factor of inStr is marked with bit value 1.
- *        Additionally, the position after the last character of inStr is also marked
- *        with bit value 1.
- * @param unique Similar to <i>factors</b>, but for each Lyndon factor only the starting
- *        position of its first occurrence is marked.
- * @param length The size of the input data (the length of inStr).
- *
- * @return The number of all Lyndon factors of inStr.
-*/
-template<typename Tdata, typename Tnum>
-Tnum lyndonFactors(const Tdata *inStr, Tnum length, BitVector<Tnum> *factors = nullptr, BitVector<Tnum> *unique = nullptr) {
-    Tnum i = 0;
-    Tnum numFactors = 0;
+/** Inputs shorter than this are always factorised on a single thread. */
+const long MinParallelLyndonLength = 1L << 22;
 
-    while (i < length) {
+
+/** Duval's algorithm applied to the symbols symbol(begin), ..., symbol(end - 1).
+ * For each run of equal Lyndon factors starting before limit visit(start, factorLen, runEnd) is called,
+ * where the run covers positions [start..runEnd) and consists of factors of length factorLen.
+ * Factors starting before limit may extend up to end, which allows factorising e.g. a doubled string.
+ */
+template<typename Tnum, typename Tsymbol, typename Tvisit>
+void lyndonRuns(Tsymbol symbol, Tnum begin, Tnum end, Tnum limit, Tvisit visit) {
+    Tnum i = begin;
+
+    while (i < limit) {
         Tnum j = i + 1, k = i;
 
         // Compute the length of the longest segment consisting of repeated occurrences
         // of the same Lyndon word.
 
-        while (j < length && inStr[k] <= inStr[j]) {
-            if (inStr[k] < inStr[j])
+        while (j < end && symbol(k) <= symbol(j)) {
+            if (symbol(k) < symbol(j))
                 k = i;
             else
                 k++;
             j++;
         }
 
+        Tnum start = i;
+
+        while (i <= k)
+            i += j - k;
+
+        visit(start, j - k, i);
+    }
+}
+
+
+/** Duval's algorithm applied to inStr[begin..end) as if it was a separate string.
+ * Factor starts are marked at their absolute positions in factors and unique.
+ * @return The number of Lyndon factors of inStr[begin..end).
+ */
+template<typename Tdata, typename Tnum>
+Tnum lyndonFactorsRange(const Tdata *inStr, Tnum begin, Tnum end, BitVector<Tnum> *factors, BitVector<Tnum> *unique) {
+    Tnum numFactors = 0;
+
+    lyndonRuns([inStr](Tnum p) { return inStr[p]; }, begin, end, end, [&](Tnum start, Tnum factorLen, Tnum runEnd) {
         // For each factor store its starting position (factors).
         // Moreover, store the starting position of the first occurrence of each factor (unique).
 
         if (unique)
-            unique->set(i, true);
+            unique->set(start, true);
 
-        while(i <= k) {
+        for (Tnum i = start; i < runEnd; i += factorLen) {
             if (factors)
                 factors->set(i, true);
             ++numFactors;
-            i += j - k;
         }
+    });
+
+    return numFactors;
+}
+
+
+/** Duval's algorithm calling visit(start) for the starting position of each Lyndon factor of inStr[0..length).
+ * No memory is used for the factorisation, so it can be streamed e.g. into a file.
+ */
+template<typename Tdata, typename Tnum, typename Tvisit>
+void forEachLyndonFactor(const Tdata *inStr, Tnum length, Tvisit visit) {
+    lyndonRuns([inStr](Tnum p) { return inStr[p]; }, (Tnum) 0, length, length, [&](Tnum start, Tnum factorLen, Tnum runEnd) {
+        for (Tnum i = start; i < runEnd; i += factorLen)
+            visit(i);
+    });
+}
+
+
+/** Duval's algorithm applied to inStr·inStr.
+ * The last Lyndon factor starting within the first copy of inStr is the lexicographically minimal rotation of inStr.
+ * @return The starting position of the minimal rotation of inStr[0..length).
+ */
+template<typename Tdata, typename Tnum>
+Tnum minimalRotation(const Tdata *inStr, Tnum length) {
+    long rotation = 0;
+
+    lyndonRuns([inStr, length](long p) { return inStr[p < length ? p : p - length]; }, 0L, 2L * length, (long) length,
+               [&](long start, long, long) { rotation = start; });
+
+    return (Tnum) rotation;
+}
+
+
+/** Lexicographically compares Lyndon words inStr[a..a+aLen) and inStr[b..b+bLen).
+ * @return Negative, zero or positive value if the first word is smaller, equal or greater respectively.
+ */
+template<typename Tdata, typename Tnum>
+int compareWords(const Tdata *inStr, Tnum a, Tnum aLen, Tnum b, Tnum bLen) {
+    Tnum len = (aLen < bLen) ? aLen : bLen;
+
+    for (Tnum i = 0; i < len; ++i) {
+        if (inStr[a + i] != inStr[b + i])
+            return (inStr[a + i] < inStr[b + i]) ? -1 : 1;
     }
 
+    return (aLen < bLen) ? -1 : (aLen > bLen);
+}
+
+
+/** Multi-threaded Lyndon factorisation.
+ *
+ * The input is split into chunks (aligned to 64 positions, so threads never share a word of the bit vectors),
+ * each chunk is factorised independently with Duval's algorithm and the chunk factorisations are merged
+ * afterwards. Concatenating Lyndon words u < v gives a Lyndon word, hence repeatedly merging adjacent factors
+ * which are in increasing order yields the (unique) Lyndon factorisation of the whole input. Only the factors
+ * near chunk boundaries are affected by merging, so the merge phase is cheap.
+ *
+ * The parameters and the result are the same as for lyndonFactors().
+ * @param numThreads The number of threads to be used (0 means the number of hardware threads).
+ */
+template<typename Tdata, typename Tnum>
+Tnum lyndonFactorsParallel(const Tdata *inStr, Tnum length, BitVector<Tnum> *factors = nullptr, BitVector<Tnum> *unique = nullptr, unsigned numThreads = 0) {
+    if (numThreads == 0)
+        numThreads = std::max(1U, std::thread::hardware_concurrency());
+
+    // Merging needs both factor starts and run starts, so use temporary vectors if not provided
+    std::unique_ptr<BitVector<Tnum>> tmpFactors, tmpUnique;
+
+    if (factors == nullptr) {
+        tmpFactors = std::make_unique<BitVector<Tnum>>(length + 1);
+        factors = tmpFactors.get();
+    }
+
+    if (unique == nullptr) {
+        tmpUnique = std::make_unique<BitVector<Tnum>>(length + 1);
+        unique = tmpUnique.get();
+    }
+
+    //------------------------------------------------------------------------------------------------------------------
+    // Factorise all chunks independently
+    //------------------------------------------------------------------------------------------------------------------
+
+    Tnum chunkLen = ((length / numThreads) | 63) + 1;
+    std::vector<Tnum> chunkStart;
+
+    for (Tnum pos = 0; pos < length; pos += chunkLen)
+        chunkStart.push_back(pos);
+
+    chunkStart.push_back(length);
+
+    Tnum numChunks = chunkStart.size() - 1;
+    std::vector<Tnum> chunkFactors(numChunks, 0);
+    std::vector<std::thread> threads;
+
+    for (Tnum t = 0; t < numChunks; ++t) {
+        threads.emplace_back([=, &chunkFactors, &chunkStart]() {
+            chunkFactors[t] = lyndonFactorsRange(inStr, chunkStart[t], chunkStart[t + 1], factors, unique);
+        });
+    }
+
+    for (auto &thread : threads)
+        thread.join();
+
+    Tnum numFactors = 0;
+
+    for (Tnum t = 0; t < numChunks; ++t)
+        numFactors += chunkFactors[t];
+
+    factors->set(length, true);
+
+    //------------------------------------------------------------------------------------------------------------------
+    // Merge factors at chunk boundaries.
+    // A run of equal factors w^k starts at each position marked in unique, so the factorisation of the already
+    // processed prefix works as a stack of runs. The current run is merged into a single factor with the top run
+    // as long as the top run is smaller, and joined with the top run if both are equal.
+    //------------------------------------------------------------------------------------------------------------------
+
+    for (Tnum t = 1, pos = chunkStart[std::min(numChunks, (Tnum) 1)]; pos < length; ) {
+        Tnum curStart = pos;
+        Tnum curEnd = std::min(unique->next(curStart), length);
+        Tnum curLen = factors->next(curStart) - curStart;
+        bool merged = false;
+
+        for (Tnum topStart; (topStart = unique->prev(curStart)) >= 0; ) {
+            Tnum topLen = factors->next(topStart) - topStart;
+            int cmp = compareWords(inStr, topStart, topLen, curStart, curLen);
+
+            if (cmp > 0)
+                break;
+
+            unique->set(curStart, false);
+
+            if (cmp == 0)
+                break;
+
+            // The top run followed by the current run forms a single Lyndon factor
+            for (Tnum p = factors->next(topStart); p < curEnd; p = factors->next(p)) {
+                factors->set(p, false);
+                --numFactors;
+            }
+
+            curStart = topStart;
+            curLen = curEnd - topStart;
+            merged = true;
+        }
+
+        if (merged) {
+            // The next run may still be greater than the merged factor
+            pos = curEnd;
+        }
+        else {
+            // The next run is smaller than the current one, so the rest of the chunk stays unchanged
+            while (chunkStart[t] <= curStart)
+                ++t;
+
+            pos = chunkStart[t];
+        }
+    }
+
+    return numFactors;
+}
+
+
+/** Lyndon factorisation based on Duval's algorithm.
+ *
+ * @param inStr Input data.
+ * @param factors BitVector os size (length + 1).
+ *        Starting position of each Lyndon factor of inStr is marked with bit value 1.
+ *        Additionally, the position after the last character of inStr is also marked
+ *        with bit value 1.
+ * @param unique Similar to <i>factors</b>, but for each Lyndon factor only the starting
+ *        position of its first occurrence is marked.
+ * @param length The size of the input data (the length of inStr).
+ * @param numThreads The number of threads to be used (0 means the number of hardware threads).
+ *
+ * Long inputs are factorised with lyndonFactorsParallel() if more than one thread is requested.
+ *
+ * @return The number of all Lyndon factors of inStr.
+*/
+template<typename Tdata, typename Tnum>
+Tnum lyndonFactors(const Tdata *inStr, Tnum length, BitVector<Tnum> *factors = nullptr, BitVector<Tnum> *unique = nullptr, unsigned numThreads = 1) {
+    if (numThreads == 0)
+        numThreads = std::max(1U, std::thread::hardware_concurrency());
+
+    if (length >= MinParallelLyndonLength && numThreads > 1)
+        return lyndonFactorsParallel(inStr, length, factors, unique, numThreads);
+
+    Tnum numFactors = lyndonFactorsRange(inStr, (Tnum) 0, length, factors, unique);
+
     if (factors)
         factors->set(length, true);
 
@@ -0,0 +1,167 @@
+/**
+ * Block-based compression using Bijective Burrows-Wheeler Transform.
+ * The input file is split into blocks which are compressed in parallel,
+ * the result is written to the output file in the block-indexed container format.
+ *
+ * (c) 2023 Marcin Piątkowski, marcin.piatkowski(at)mat.umk.pl
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include <iostream>
+#include <iomanip>
+#include <cstdio>
+#include <cstdlib>
+#include <chrono>
+#include <atomic>
+#include <vector>
+
+#include <unistd.h>
+
+#include "bbwt_compress.hpp"
+#include "MappedFile.hpp"
+#include "ThreadTeam.hpp"
+
+using namespace std;
+
+
+int main(int argc, char **argv) {
+    long blockSize = DefaultBlockSize;
+    unsigned numThreads = 0;
+    int opt;
+
+    while ((opt = getopt(argc, argv, "b:t:")) != -1) {
+        switch (opt) {
+            case 'b':
+                blockSize = atol(optarg) * 1024;
+                break;
+            case 't':
+                numThreads = atoi(optarg);
+                break;
+            default:
+                argc = 0;
+        }
+    }
+
+    if (argc - optind != 2 || blockSize <= 0 || blockSize > (1L << 30)) {
+        cerr << "Usage " << argv[0] << " [-b block_size_KiB] [-t num_threads] input_file output_file" << endl;
+
+        return 1;
+    }
+
+    const char *inName = argv[optind];
+    const char *outName = argv[optind + 1];
+
+    //-------------------------------------------------------------------------
+    // Map the input file into memory
+    //-------------------------------------------------------------------------
+
+    MappedFile inFile;
+
+    if (!inFile.openRead(inName)) {
+        cerr << argv[0] << " error: cannot read input file " << inName << endl;
+
+        return 1;
+    }
+
+    size_t dataSize = inFile.size();
+    size_t numBlocks = (dataSize + blockSize - 1) / blockSize;
+
+    cout << "Input size = " << dataSize << " B, " << numBlocks << " block(s)" << endl;
+
+    //-------------------------------------------------------------------------
+    // Compress all blocks in parallel
+    //-------------------------------------------------------------------------
+
+    auto start = chrono::high_resolution_clock::now();
+
+    vector<vector<unsigned char>> blocks(numBlocks);
+    vector<uint32_t> checksums(numBlocks);
+    atomic<size_t> nextBlock(0);
+    atomic<bool> failed(false);
+    ThreadTeam team(numThreads);
+
+    team.run([&](unsigned, unsigned) {
+        BlockWorkspace ws;
+
+        for (size_t b; (b = nextBlock++) < numBlocks; ) {
+            size_t blockStart = b * blockSize;
+            int blockLen = min((size_t) blockSize, dataSize - blockStart);
+
+            if (compressBlock(inFile.data() + blockStart, blockLen, blocks[b], ws) != 0)
+                failed = true;
+
+            checksums[b] = crc32(inFile.data() + blockStart, blockLen);
+        }
+    });
+
+    if (failed) {
+        cerr << argv[0] << " error: block compression failed" << endl;
+
+        return -1;
+    }
+
+    auto end = chrono::high_resolution_clock::now();
+    auto duration = chrono::duration_cast<chrono::milliseconds>(end - start);
+
+    //-------------------------------------------------------------------------
+    // Write the container: header, block index and compressed blocks
+    //-------------------------------------------------------------------------
+
+    vector<unsigned char> header(ContainerHeaderSize + numBlocks * ContainerIndexEntrySize, 0);
+    size_t outSize = header.size();
+
+    memcpy(header.data(), ContainerMagic, 4);
+    header[4] = ContainerVersion;
+    putUInt32(header.data() + 8, blockSize);
+    putUInt64(header.data() + 12, numBlocks);
+
+    for (size_t b=0; b<numBlocks; ++b) {
+        unsigned char *entry = header.data() + ContainerHeaderSize + b * ContainerIndexEntrySize;
+
+        putUInt32(entry, min((size_t) blockSize, dataSize - b * blockSize));
+        putUInt32(entry + 4, blocks[b].size());
+        putUInt32(entry + 8, checksums[b]);
+        outSize += blocks[b].size();
+    }
+
+    FILE *outFile = fopen(outName, "wb");
+    bool written = (outFile != nullptr) && fwrite(header.data(), 1, header.size(), outFile) == header.size();
+
+    for (size_t b=0; written && b<numBlocks; ++b)
+        written = fwrite(blocks[b].data(), 1, blocks[b].size(), outFile) == blocks[b].size();
+
+    if (outFile == nullptr || fclose(outFile) != 0 || !written) {
+        cerr << argv[0] << " error: cannot write output file " << outName << endl;
+
+        return 1;
+    }
+
+    //-------------------------------------------------------------------------
+
+    cout << "Output size = " << outSize << " B";
+
+    if (dataSize > 0)
+        cout << " (" << fixed << setprecision(3) << 8.0 * outSize / dataSize << " bits per byte)";
+
+    cout << endl;
+    cout << "Runtime " << duration.count()/1000 << "." << setfill('0') << setw(3) << duration.count()%1000 << " s" << endl;
+
+    return 0;
+}
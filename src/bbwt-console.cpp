@@ -1,6 +1,6 @@
 /**
  * Bijective Burrows-Wheeler Transform computation example.
- * Input data is read from the standard input,
+ * Input data is read from the standard input (each line is transformed as a separate record),
  * output data is written to the standard output.
  *
  * (c) 2023 Marcin Piątkowski, marcin.piatkowski(at)mat.umk.pl
@@ -24,31 +24,56 @@
  * SOFTWARE.
  */
 
-#include <cstdio>
-#include <cstring>
 
-#include "bbwt.hpp"
+#include <iostream>
+#include <cstdlib>
+
+#include <unistd.h>
+
+#include "bbwt_records.hpp"
 
 using namespace std;
 using Tnum = int;
 
 
-const int MaxDataSize = 2048;
+int main(int argc, char **argv) {
+    long chunkSize = 4L << 20;
+    unsigned numThreads = 0;
+    bool decode = false;
+    int opt;
+
+    while ((opt = getopt(argc, argv, "db:t:")) != -1) {
+        switch (opt) {
+            case 'd':
+                decode = true;
+                break;
+            case 'b':
+                chunkSize = atol(optarg) * 1024;
+                break;
+            case 't':
+                numThreads = atoi(optarg);
+                break;
+            default:
+                argc = 0;
+        }
+    }
+
+    if (argc != optind || chunkSize <= 0) {
+        cerr << "Usage " << argv[0] << " [-d] [-b chunk_size_KiB] [-t num_threads] < input > output" << endl;
 
+        return 1;
+    }
 
-int main() {
-    unsigned char inData[MaxDataSize], outData[MaxDataSize];
-    Tnum csa[MaxDataSize];
+    //-------------------------------------------------------------------------
+    // Transform (or restore) all lines of the standard input
+    //-------------------------------------------------------------------------
 
-    printf("> ");
+    BbwtRecordProcessor<Tnum> processor(decode ? unbbwtRecord<Tnum> : bbwtRecord<Tnum>, numThreads, chunkSize);
 
-    while (fgets((char *)inData, MaxDataSize, stdin)) {
-        Tnum len = strlen((char *)inData) - 1;
-        inData[len] = outData[len] = '\0';
+    if (processor.run() != 0) {
+        cerr << argv[0] << " error: cannot transform the input records" << endl;
 
-        bbwt(inData, outData, csa, len);
-        printf("%s\n", outData);
-        printf("\n> ");
+        return 1;
     }
 
     return 0;
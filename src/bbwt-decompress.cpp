@@ -0,0 +1,174 @@
+/**
+ * Block-based decompression using inverse Bijective Burrows-Wheeler Transform.
+ * The input file in the block-indexed container format is decompressed in parallel
+ * directly into the memory-mapped output file.
+ *
+ * (c) 2023 Marcin Piątkowski, marcin.piatkowski(at)mat.umk.pl
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include <iostream>
+#include <iomanip>
+#include <cstdio>
+#include <cstdlib>
+#include <chrono>
+#include <atomic>
+#include <vector>
+
+#include <unistd.h>
+
+#include "bbwt_compress.hpp"
+#include "MappedFile.hpp"
+#include "ThreadTeam.hpp"
+
+using namespace std;
+
+
+int main(int argc, char **argv) {
+    unsigned numThreads = 0;
+    int opt;
+
+    while ((opt = getopt(argc, argv, "t:")) != -1) {
+        switch (opt) {
+            case 't':
+                numThreads = atoi(optarg);
+                break;
+            default:
+                argc = 0;
+        }
+    }
+
+    if (argc - optind != 2) {
+        cerr << "Usage " << argv[0] << " [-t num_threads] input_file output_file" << endl;
+
+        return 1;
+    }
+
+    const char *inName = argv[optind];
+    const char *outName = argv[optind + 1];
+
+    //-------------------------------------------------------------------------
+    // Map the input file into memory and read the container header and index
+    //-------------------------------------------------------------------------
+
+    MappedFile inFile;
+
+    if (!inFile.openRead(inName)) {
+        cerr << argv[0] << " error: cannot read input file " << inName << endl;
+
+        return 1;
+    }
+
+    const unsigned char *inData = inFile.data();
+    size_t inSize = inFile.size();
+
+    if (inSize < ContainerHeaderSize || memcmp(inData, ContainerMagic, 4) != 0 || inData[4] != ContainerVersion) {
+        cerr << argv[0] << " error: " << inName << " is not a compressed file" << endl;
+
+        return 1;
+    }
+
+    uint32_t blockSize = getUInt32(inData + 8);
+    uint64_t numBlocks = getUInt64(inData + 12);
+
+    if (numBlocks > (inSize - ContainerHeaderSize) / ContainerIndexEntrySize) {
+        cerr << argv[0] << " error: corrupted block index" << endl;
+
+        return 1;
+    }
+
+    // Positions of all blocks in the input and output data
+    vector<size_t> inOffset(numBlocks + 1), outOffset(numBlocks + 1);
+    vector<uint32_t> checksums(numBlocks);
+    inOffset[0] = ContainerHeaderSize + numBlocks * ContainerIndexEntrySize;
+    outOffset[0] = 0;
+
+    for (size_t b=0; b<numBlocks; ++b) {
+        const unsigned char *entry = inData + ContainerHeaderSize + b * ContainerIndexEntrySize;
+        uint32_t origSize = getUInt32(entry);
+
+        if (origSize == 0 || origSize > blockSize || origSize > (uint32_t) numeric_limits<int>::max()) {
+            cerr << argv[0] << " error: corrupted block index" << endl;
+
+            return 1;
+        }
+
+        inOffset[b + 1] = inOffset[b] + getUInt32(entry + 4);
+        outOffset[b + 1] = outOffset[b] + origSize;
+        checksums[b] = getUInt32(entry + 8);
+    }
+
+    if (inOffset[numBlocks] > inSize) {
+        cerr << argv[0] << " error: input data truncated" << endl;
+
+        return 1;
+    }
+
+    size_t dataSize = outOffset[numBlocks];
+
+    cout << "Output size = " << dataSize << " B, " << numBlocks << " block(s)" << endl;
+
+    //-------------------------------------------------------------------------
+    // Decompress all blocks in parallel into the mapped output file
+    //-------------------------------------------------------------------------
+
+    MappedFile outFile;
+
+    if (!outFile.create(outName, dataSize)) {
+        cerr << argv[0] << " error: cannot create output file " << outName << endl;
+
+        return 1;
+    }
+
+    auto start = chrono::high_resolution_clock::now();
+
+    atomic<size_t> nextBlock(0);
+    atomic<bool> failed(false);
+    ThreadTeam team(numThreads);
+
+    team.run([&](unsigned, unsigned) {
+        BlockWorkspace ws;
+
+        for (size_t b; (b = nextBlock++) < numBlocks; ) {
+            unsigned char *outData = outFile.data() + outOffset[b];
+            size_t outLen = outOffset[b + 1] - outOffset[b];
+
+            if (decompressBlock(inData + inOffset[b], inOffset[b + 1] - inOffset[b], outData, outLen, ws) != 0
+                || crc32(outData, outLen) != checksums[b]) {
+                failed = true;
+            }
+        }
+    });
+
+    if (failed) {
+        cerr << argv[0] << " error: corrupted compressed data" << endl;
+
+        return -1;
+    }
+
+    auto end = chrono::high_resolution_clock::now();
+    auto duration = chrono::duration_cast<chrono::milliseconds>(end - start);
+
+    //-------------------------------------------------------------------------
+
+    cout << "Runtime " << duration.count()/1000 << "." << setfill('0') << setw(3) << duration.count()%1000 << " s" << endl;
+
+    return 0;
+}
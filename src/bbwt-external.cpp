@@ -0,0 +1,82 @@
+/**
+ * External-memory Bijective Burrows-Wheeler Transform computation example.
+ * Input data is read from a file and the result is stored in a file, using a given amount of memory
+ * and temporary files (see bbwt_external.hpp).
+ *
+ * (c) 2023 Marcin Piątkowski, marcin.piatkowski(at)mat.umk.pl
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+
+#include <iostream>
+#include <iomanip>
+#include <cstdlib>
+#include <chrono>
+
+#include <unistd.h>
+
+#include "bbwt_external.hpp"
+
+using namespace std;
+
+
+int main(int argc, char **argv) {
+    long memoryMiB = 1024;
+    const char *tmpDir = nullptr;
+    int opt;
+
+    while ((opt = getopt(argc, argv, "m:T:")) != -1) {
+        switch (opt) {
+            case 'm':
+                memoryMiB = atol(optarg);
+                break;
+            case 'T':
+                tmpDir = optarg;
+                break;
+            default:
+                argc = 0;
+        }
+    }
+
+    if (argc != optind + 2 || memoryMiB <= 0) {
+        cerr << "Usage " << argv[0] << " [-m memory_MiB] [-T tmp_dir] input_file output_file" << endl;
+
+        return 1;
+    }
+
+    //-------------------------------------------------------------------------
+    // Compute BBWT and measure the computation time
+    //-------------------------------------------------------------------------
+
+    auto start = chrono::high_resolution_clock::now();
+
+    if (bbwtExternal(argv[optind], argv[optind + 1], (size_t) memoryMiB << 20, tmpDir) != 0) {
+        cerr << argv[0] << " error: BBWT computation failed" << endl;
+
+        return 1;
+    }
+
+    auto end = chrono::high_resolution_clock::now();
+    auto duration = chrono::duration_cast<chrono::milliseconds>(end - start);
+
+    cout << "Runtime " << duration.count()/1000 << "." << setfill('0') << setw(3) << duration.count()%1000 << " s" << endl;
+
+    return 0;
+}
@@ -1,6 +1,8 @@
 /**
  * Bijective Burrows-Wheeler Transform computation example.
- * Input data is read from a file, output data is written to a file.
+ * Input data is memory-mapped from a file, output data is written
+ * directly to a memory-mapped output file. With -m many files are
+ * transformed with reading and writing overlapped with the computation.
  *
  * (c) 2023 Marcin Piątkowski, marcin.piatkowski(at)mat.umk.pl
  *
@@ -25,87 +27,490 @@
 
 #include <iostream>
 #include <iomanip>
+#include <cstdint>
 #include <cstdio>
+#include <cstdlib>
 #include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <memory>
+#include <mutex>
 #include <new>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
 
 #include "bbwt.hpp"
+#include "MappedFile.hpp"
 
 using namespace std;
-using Tnum = int;
 
 
-int main(int argc, char **argv) {
-    unsigned char *inData = nullptr;
-    Tnum *csa = nullptr;
-    FILE *inFile, *outFile;
+/** A suffix array buffer reused for consecutive inputs (it grows only if a longer input is given). */
+template<typename Tsa>
+struct CsaBuffer {
+    unique_ptr<Tsa[]> entries;
+    size_t size = 0;
 
-    if(argc != 3) {
-        cerr << "Usage " << argv[0] << " input_file output_file" << endl;
+    /** @return the buffer of at least len entries or nullptr if it cannot be allocated */
+    Tsa *reserve(size_t len) {
+        if (len > size) {
+            entries.reset();
+            size = 0;
 
-        return 1;
+            try {
+                entries.reset(new Tsa[len]);
+                size = len;
+            }
+            catch (const bad_alloc &e) {
+                return nullptr;
+            }
+        }
+
+        return entries.get();
+    }
+};
+
+
+/** Suffix array buffers for both index widths chosen by transformSymbols. */
+struct CsaBuffers {
+    CsaBuffer<int> narrow;
+    CsaBuffer<Int40> wide;
+
+    CsaBuffer<int> &get(int) {
+        return narrow;
+    }
+
+    CsaBuffer<Int40> &get(long) {
+        return wide;
+    }
+};
+
+
+/** Computes BBWT of the input data into the output data (the same buffer may be given for both).
+ * The index type Tnum has to be wide enough to address dataSize positions,
+ * the circular suffix array is stored as an array of Tsa.
+ * @param duration the time of BBWT computation
+ * @return 0 after successful computation, non-zero in case of any error
+ */
+template<typename Tdata, typename Tnum, typename Tsa = Tnum>
+int transform(const char *progName, const Tdata *inData, Tdata *outData, Tnum dataSize, unsigned numThreads,
+              CsaBuffers &buffers, chrono::milliseconds &duration) {
+    Tsa *csa = buffers.get(dataSize).reserve(dataSize);
+
+    if (csa == nullptr) {
+        cerr << progName << ": Memory allocation error" << endl;
+
+        return 2;
     }
 
     //-------------------------------------------------------------------------
-    // Read data from the input file
+    // Compute BBWT (over the effective alphabet of the input) and measure the computation time
     //-------------------------------------------------------------------------
 
-    inFile = fopen(argv[1], "rb");
+    auto start = chrono::high_resolution_clock::now();
 
-    fseek(inFile, 0, SEEK_END);
-    Tnum dataSize = ftell(inFile);
-    rewind(inFile);
+    if (bbwt(inData, outData, csa, dataSize, (Tnum) 0, numThreads) != 0) {
+        cerr << progName << " error: BBWT computation failed" << endl;
 
-    cout << "Input size = " << dataSize << " B" << endl;
+        return -1;
+    }
+
+    auto end = chrono::high_resolution_clock::now();
+    duration = chrono::duration_cast<chrono::milliseconds>(end - start);
+
+    return 0;
+}
+
+
+/** Computes BBWT of the data seen as a sequence of symbols of type Tdata (in the native byte order)
+ * using the narrowest index type sufficient for the number of symbols
+ * (larger inputs use 64-bit indices with the suffix array packed into 40-bit entries).
+ * @return 0 after successful computation, non-zero in case of any error
+ */
+template<typename Tdata>
+int transformSymbols(const char *progName, const unsigned char *inData, unsigned char *outData, size_t dataSize, unsigned numThreads,
+                     CsaBuffers &buffers, chrono::milliseconds &duration) {
+    size_t numSymbols = dataSize / sizeof(Tdata);
+
+    if (numSymbols <= MaxIntLength) {
+        return transform<Tdata, int>(progName, (const Tdata *) inData, (Tdata *) outData, (int) numSymbols, numThreads, buffers, duration);
+    }
+    else {
+        return transform<Tdata, long, Int40>(progName, (const Tdata *) inData, (Tdata *) outData, (long) numSymbols, numThreads, buffers, duration);
+    }
+}
+
+
+/** Computes BBWT of symbols of the given width (1, 2 or 4 bytes).
+ * @return 0 after successful computation, non-zero in case of any error
+ */
+int transformData(const char *progName, int symbolWidth, const unsigned char *inData, unsigned char *outData, size_t dataSize,
+                  unsigned numThreads, CsaBuffers &buffers, chrono::milliseconds &duration) {
+    if (symbolWidth == 1) {
+        return transformSymbols<uint8_t>(progName, inData, outData, dataSize, numThreads, buffers, duration);
+    }
+    else if (symbolWidth == 2) {
+        return transformSymbols<uint16_t>(progName, inData, outData, dataSize, numThreads, buffers, duration);
+    }
+    else {
+        return transformSymbols<uint32_t>(progName, inData, outData, dataSize, numThreads, buffers, duration);
+    }
+}
+
+
+/** @return the duration in seconds with millisecond precision */
+string seconds(const chrono::milliseconds &duration) {
+    ostringstream out;
+    out << duration.count()/1000 << "." << setfill('0') << setw(3) << duration.count()%1000 << " s";
+
+    return out.str();
+}
+
+
+//-----------------------------------------------------------------------------
+// Pipelined transform of many files
+//-----------------------------------------------------------------------------
+
+/** A file passing through the pipeline, its buffer is reused for the following files. */
+struct PipelineJob {
+    const char *inPath = nullptr;
+    string outPath;
+    vector<unsigned char> data;
+    size_t dataSize = 0;
+    bool ready = false;                     // the file was read (and transformed) successfully
+};
+
+
+/** A queue passing jobs between the stages of the pipeline (nullptr marks the end of the input). */
+class JobQueue {
+public:
+    void push(PipelineJob *job) {
+        {
+            lock_guard<mutex> lock(queueMutex);
+            jobs.push_back(job);
+        }
+
+        available.notify_one();
+    }
+
+    PipelineJob *pop() {
+        unique_lock<mutex> lock(queueMutex);
+        available.wait(lock, [this]() { return !jobs.empty(); });
+
+        PipelineJob *job = jobs.front();
+        jobs.pop_front();
+
+        return job;
+    }
+
+private:
+    deque<PipelineJob *> jobs;
+    mutex queueMutex;
+    condition_variable available;
+};
+
+
+/** Reads the whole file into the buffer of the job.
+ * @return an empty string after success or the description of an error
+ */
+string readFile(PipelineJob &job, int symbolWidth) {
+    struct stat inStat;
+    int inFile = open(job.inPath, O_RDONLY);
+
+    if (inFile < 0 || fstat(inFile, &inStat) != 0) {
+        if (inFile >= 0)
+            close(inFile);
+
+        return string("cannot open input file ") + job.inPath;
+    }
+
+    job.dataSize = inStat.st_size;
+
+    if (job.dataSize % symbolWidth != 0) {
+        close(inFile);
+
+        return string("the size of input file ") + job.inPath + " is not a multiple of " + to_string(symbolWidth) + " B";
+    }
 
     try {
-        inData = new unsigned char[dataSize];
-        csa = new Tnum[dataSize];
+        if (job.data.size() < job.dataSize)
+            job.data.resize(job.dataSize);
     }
     catch (const bad_alloc &e) {
-        cerr << argv[0] << ": Memory allocation error" << endl;
+        close(inFile);
 
-        return 2;
+        return string("cannot allocate memory for input file ") + job.inPath;
     }
 
-    Tnum dataCount = fread((char*) inData, sizeof(char), dataSize, inFile);
-    fclose(inFile);
+    posix_fadvise(inFile, 0, 0, POSIX_FADV_SEQUENTIAL);
 
-    if (dataCount != dataSize) {
-        cerr << argv[0] << " error: input data read partially" << endl;
+    size_t done = 0;
 
-        return 1;
+    while (done < job.dataSize) {
+        ssize_t count = read(inFile, job.data.data() + done, job.dataSize - done);
+
+        if (count <= 0)
+            break;
+
+        done += count;
     }
 
+    close(inFile);
+
+    if (done != job.dataSize)
+        return string("cannot read input file ") + job.inPath;
+
+    return string();
+}
+
+
+/** Writes the transformed buffer of the job to its output file.
+ * @return true after success, false in case of any error
+ */
+bool writeFile(const PipelineJob &job) {
+    int outFile = open(job.outPath.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+
+    if (outFile < 0)
+        return false;
+
+    size_t done = 0;
+
+    while (done < job.dataSize) {
+        ssize_t count = write(outFile, job.data.data() + done, job.dataSize - done);
+
+        if (count <= 0)
+            break;
+
+        done += count;
+    }
+
+    return close(outFile) == 0 && done == job.dataSize;
+}
+
+
+/** Computes BBWT of each of the given files and stores it in the file with the suffix .bbwt appended to the name.
+ * Reading, transforming and writing are overlapped: the next file is read by the reader thread and the previous
+ * one is written by the writer thread while the current one is transformed (in place) by the calling thread.
+ * @return 0 if all files were transformed successfully, non-zero otherwise
+ */
+int transformFiles(const char *progName, char **inPaths, int numFiles, int symbolWidth, unsigned numThreads) {
+    // One buffer for each stage of the pipeline
+    const int NumJobs = 3;
+
+    PipelineJob jobs[NumJobs];
+    JobQueue freeJobs, readJobs, doneJobs;
+    mutex outputMutex;
+    bool failed = false;
+
+    for (PipelineJob &job : jobs)
+        freeJobs.push(&job);
+
+    auto start = chrono::high_resolution_clock::now();
+    size_t totalSize = 0;
+
     //-------------------------------------------------------------------------
-    // Compute BBWT and measure the computation time
+    // The reader thread fills free buffers, the writer thread empties transformed ones
     //-------------------------------------------------------------------------
 
-    auto start = chrono::high_resolution_clock::now();
+    thread reader([&]() {
+        for (int i = 0; i < numFiles; ++i) {
+            PipelineJob *job = freeJobs.pop();
 
-    if (bbwt(inData, inData, csa, dataSize) != 0) {
-        cerr << argv[0] << " error: BBWT computation failed" << endl;
+            job->inPath = inPaths[i];
+            job->outPath = string(inPaths[i]) + ".bbwt";
 
-        return -1;
+            string error = readFile(*job, symbolWidth);
+            job->ready = error.empty();
+
+            if (!job->ready) {
+                lock_guard<mutex> lock(outputMutex);
+                cerr << progName << " error: " << error << endl;
+            }
+
+            readJobs.push(job);
+        }
+
+        readJobs.push(nullptr);
+    });
+
+    thread writer([&]() {
+        PipelineJob *job;
+
+        while ((job = doneJobs.pop()) != nullptr) {
+            if (job->ready && !writeFile(*job)) {
+                lock_guard<mutex> lock(outputMutex);
+                cerr << progName << " error: cannot write output file " << job->outPath << endl;
+                failed = true;
+            }
+
+            freeJobs.push(job);
+        }
+    });
+
+    //-------------------------------------------------------------------------
+    // Transform the files in the order they are read
+    //-------------------------------------------------------------------------
+
+    CsaBuffers buffers;
+    PipelineJob *job;
+
+    while ((job = readJobs.pop()) != nullptr) {
+        chrono::milliseconds duration(0);
+
+        if (job->ready && job->dataSize > 0) {
+            job->ready = transformData(progName, symbolWidth, job->data.data(), job->data.data(), job->dataSize,
+                                       numThreads, buffers, duration) == 0;
+        }
+
+        {
+            lock_guard<mutex> lock(outputMutex);
+
+            if (job->ready) {
+                cout << job->inPath << ": " << job->dataSize << " B, runtime " << seconds(duration) << endl;
+                totalSize += job->dataSize;
+            }
+            else {
+                failed = true;
+            }
+        }
+
+        doneJobs.push(job);
     }
 
+    doneJobs.push(nullptr);
+
+    reader.join();
+    writer.join();
+
     auto end = chrono::high_resolution_clock::now();
-    auto duration = chrono::duration_cast<chrono::milliseconds>(end - start);
+
+    cout << "Total " << totalSize << " B in " << seconds(chrono::duration_cast<chrono::milliseconds>(end - start)) << endl;
+
+    return failed ? 1 : 0;
+}
+
+
+int main(int argc, char **argv) {
+    MappedFile inFile, outFile;
+    struct stat inStat, outStat;
+
+    int symbolWidth = 1;
+    bool manyFiles = false;
+    unsigned numThreads = 0;                // By default use all hardware threads
+    int opt;
+
+    while ((opt = getopt(argc, argv, "mw:t:")) != -1) {
+        switch (opt) {
+            case 'm':
+                manyFiles = true;
+                break;
+            case 'w':
+                symbolWidth = atoi(optarg);
+                break;
+            case 't':
+                numThreads = atoi(optarg);
+                break;
+            default:
+                argc = 0;
+        }
+    }
+
+    bool validArgs = manyFiles ? argc > optind : (argc == optind + 2 || argc == optind + 3);
+
+    if (!validArgs || (symbolWidth != 1 && symbolWidth != 2 && symbolWidth != 4)) {
+        cerr << "Usage " << argv[0] << " [-w symbol_bytes] [-t num_threads] input_file output_file [num_threads]" << endl;
+        cerr << "      " << argv[0] << " -m [-w symbol_bytes] [-t num_threads] input_file..." << endl;
+
+        return 1;
+    }
+
+    if (manyFiles)
+        return transformFiles(argv[0], argv + optind, argc - optind, symbolWidth, numThreads);
+
+    const char *inPath = argv[optind];
+    const char *outPath = argv[optind + 1];
+
+    if (argc == optind + 3)
+        numThreads = atoi(argv[optind + 2]);
 
     //-------------------------------------------------------------------------
-    // Write result to the output file
+    // Map the input file into memory and create the output file of the same size,
+    // so the result is stored directly in the page cache of the output file.
+    // If both names refer to the same file the transform is computed in place.
     //-------------------------------------------------------------------------
 
-    outFile = fopen(argv[2], "wb");
-    fwrite((char*) inData, sizeof(char), dataSize, outFile);
-    fclose(outFile);
+    if (stat(inPath, &inStat) != 0) {
+        cerr << argv[0] << " error: cannot open input file " << inPath << endl;
+
+        return 1;
+    }
+
+    size_t dataSize = inStat.st_size;
+
+    cout << "Input size = " << dataSize << " B" << endl;
+
+    if (dataSize % symbolWidth != 0) {
+        cerr << argv[0] << " error: the size of input file " << inPath << " is not a multiple of " << symbolWidth << " B" << endl;
+
+        return 1;
+    }
 
-    delete[] inData;
-    delete[] csa;
+    bool inPlace = (stat(outPath, &outStat) == 0 && inStat.st_dev == outStat.st_dev && inStat.st_ino == outStat.st_ino);
+
+    if (inPlace) {
+        if (!outFile.openWrite(outPath)) {
+            cerr << argv[0] << " error: cannot map file " << outPath << endl;
+
+            return 1;
+        }
+    }
+    else {
+        if (!inFile.openRead(inPath)) {
+            cerr << argv[0] << " error: cannot map input file " << inPath << endl;
+
+            return 1;
+        }
+
+        if (!outFile.create(outPath, dataSize)) {
+            cerr << argv[0] << " error: cannot create output file " << outPath << endl;
+
+            return 1;
+        }
+    }
+
+    MappedFile &source = inPlace ? outFile : inFile;
+
+    if (source.size() != dataSize) {
+        cerr << argv[0] << " error: input file " << inPath << " changed while being read" << endl;
+
+        return 1;
+    }
+
+    if (dataSize > 0)
+        madvise(source.data(), dataSize, MADV_WILLNEED);
 
     //-------------------------------------------------------------------------
+    // Compute BBWT of the sequence of symbols of the given width
+    //-------------------------------------------------------------------------
 
-    cout << "Runtime " << duration.count()/1000 << "." << fixed << setprecision(3) << duration.count()%1000 << " s" << endl;
+    int result = 0;
 
-    return 0;
+    if (dataSize > 0) {
+        CsaBuffers buffers;
+        chrono::milliseconds duration(0);
+
+        result = transformData(argv[0], symbolWidth, source.data(), outFile.data(), dataSize, numThreads, buffers, duration);
+
+        if (result == 0)
+            cout << "Runtime " << seconds(duration) << endl;
+    }
+
+    return result;
 }
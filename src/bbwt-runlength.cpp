@@ -0,0 +1,174 @@
+/**
+ * Run-length encoded Bijective Burrows-Wheeler Transform computation example.
+ * BBWT of a (memory-mapped) file is computed in space proportional to the number of its runs
+ * (see bbwt_runlength.hpp) and stored as a sequence of runs: each run is a symbol byte followed by its length
+ * as a LEB128 variable-length integer. With -x such a file is expanded back into plain BBWT.
+ *
+ * (c) 2023 Marcin Piątkowski, marcin.piatkowski(at)mat.umk.pl
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include <iostream>
+#include <iomanip>
+#include <fstream>
+#include <chrono>
+
+#include <unistd.h>
+
+#include "bbwt_runlength.hpp"
+#include "MappedFile.hpp"
+
+using namespace std;
+
+
+/** Computes BBWT of inData[0..len) and writes its runs to out.
+ * @return 0 after successful computation, non-zero in case of any error
+ */
+int encode(const char *progName, const unsigned char *inData, long len, ofstream &out) {
+    RunLengthBbwtBuilder<unsigned char, long> builder;
+    long numRuns = 0;
+
+    try {
+        long factorStart = 0;
+
+        forEachLyndonFactor(inData, len, [&](long start) {
+            if (start > factorStart)
+                builder.addFactor(inData + factorStart, start - factorStart);
+
+            factorStart = start;
+        });
+
+        if (len > factorStart)
+            builder.addFactor(inData + factorStart, len - factorStart);
+    }
+    catch (const bad_alloc &e) {
+        cerr << progName << ": Memory allocation error" << endl;
+
+        return 2;
+    }
+
+    builder.forEachRun([&](unsigned char symbol, long length) {
+        out.put((char) symbol);
+
+        for (unsigned long value = length; ; value >>= 7) {
+            if (value < 0x80) {
+                out.put((char) value);
+                break;
+            }
+
+            out.put((char) ((value & 0x7f) | 0x80));
+        }
+
+        ++numRuns;
+    });
+
+    cout << "Runs = " << numRuns << ", working memory = " << builder.memoryUsage() << " B" << endl;
+
+    return 0;
+}
+
+
+/** Expands runs stored in inData[0..len) into out.
+ * @return 0 after successful computation, non-zero in case of any error
+ */
+int expand(const char *progName, const unsigned char *inData, long len, ofstream &out) {
+    for (long pos = 0; pos < len; ) {
+        unsigned char symbol = inData[pos++];
+        unsigned long length = 0;
+        int shift = 0;
+
+        do {
+            if (pos == len || shift > 56) {
+                cerr << progName << " error: malformed run-length input" << endl;
+
+                return 1;
+            }
+
+            length |= (unsigned long) (inData[pos] & 0x7f) << shift;
+            shift += 7;
+        } while (inData[pos++] & 0x80);
+
+        for (unsigned long i = 0; i < length; ++i)
+            out.put((char) symbol);
+    }
+
+    return 0;
+}
+
+
+int main(int argc, char **argv) {
+    MappedFile inFile;
+    bool expandRuns = false;
+    int opt;
+
+    while ((opt = getopt(argc, argv, "x")) != -1) {
+        switch (opt) {
+            case 'x':
+                expandRuns = true;
+                break;
+            default:
+                argc = 0;
+        }
+    }
+
+    if (argc != optind + 2) {
+        cerr << "Usage " << argv[0] << " [-x] input_file output_file" << endl;
+
+        return 1;
+    }
+
+    if (!inFile.openRead(argv[optind])) {
+        cerr << argv[0] << " error: cannot read input file " << argv[optind] << endl;
+
+        return 1;
+    }
+
+    ofstream out(argv[optind + 1], ios::binary);
+
+    if (!out) {
+        cerr << argv[0] << " error: cannot create output file " << argv[optind + 1] << endl;
+
+        return 1;
+    }
+
+    //-------------------------------------------------------------------------
+    // Compute (or expand) run-length encoded BBWT and measure the computation time
+    //-------------------------------------------------------------------------
+
+    auto start = chrono::high_resolution_clock::now();
+
+    int result = expandRuns ? expand(argv[0], inFile.data(), inFile.size(), out)
+                            : encode(argv[0], inFile.data(), inFile.size(), out);
+
+    out.close();
+
+    if (result == 0 && !out) {
+        cerr << argv[0] << " error: cannot write output file " << argv[optind + 1] << endl;
+
+        return 1;
+    }
+
+    auto end = chrono::high_resolution_clock::now();
+    auto duration = chrono::duration_cast<chrono::milliseconds>(end - start);
+
+    cout << "Runtime " << duration.count()/1000 << "." << setfill('0') << setw(3) << duration.count()%1000 << " s" << endl;
+
+    return result;
+}
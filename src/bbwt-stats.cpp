@@ -0,0 +1,281 @@
+/**
+ * Statistics of Bijective Burrows-Wheeler Transform.
+ * For each given file (or each regular file in a given directory) computes the alphabet size,
+ * the number of Lyndon factors (all and unique) and the number of character runs in BBWT and BWT.
+ * The results are printed as rows of a Markdown table (the same as in README.md).
+ *
+ * (c) 2023 Marcin Piątkowski, marcin.piatkowski(at)mat.umk.pl
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+
+#include <iostream>
+#include <iomanip>
+#include <cstdio>
+#include <cstdlib>
+#include <algorithm>
+#include <atomic>
+#include <filesystem>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <unistd.h>
+
+#include "bbwt.hpp"
+#include "MappedFile.hpp"
+#include "ThreadTeam.hpp"
+
+using namespace std;
+
+
+struct FileStats {
+    string name;
+    size_t size = 0;
+    int alphabet = 0;
+    long numFactors = 0;
+    long numUniqueFactors = 0;
+    long bbwtRuns = 0;
+    long bwtRuns = 0;
+    bool failed = false;
+};
+
+
+/** Computes all statistics of the mapped file in a single pass of each stage.
+ * Character runs are counted while the transforms are retrieved from circular suffix arrays,
+ * so neither BBWT nor BWT is stored.
+ * @return 0 after successful computation, non-zero in case of any error
+ */
+template<typename Tnum>
+int computeStats(const unsigned char *inData, Tnum len, FileStats &stats, ThreadTeam *team) {
+    bool present[256] = {false};
+
+    for (Tnum i=0; i<len; ++i)
+        present[inData[i]] = true;
+
+    stats.alphabet = count(present, present + 256, true);
+
+    if (len == 0)
+        return 0;
+
+    //-------------------------------------------------------------------------
+    // Lyndon factorisation
+    //-------------------------------------------------------------------------
+
+    BitVector<Tnum> lFac(len + 1);
+    BitVector<Tnum> unique(len + 1);
+
+    stats.numFactors = lyndonFactors(inData, len, &lFac, &unique, team ? team->size() : 1);
+    unique.buildRankSelect();
+    stats.numUniqueFactors = unique.rank1(len);
+    lFac.buildRankSelect();
+
+    // Both buffers are released on every path, also if the second allocation fails
+    unique_ptr<Tnum[]> csaBuffer;
+    unique_ptr<unsigned short[]> extBuffer;
+
+    try {
+        csaBuffer.reset(new Tnum[len + 1]);
+        extBuffer.reset(new unsigned short[len + 1]);
+    }
+    catch (const bad_alloc &e) {
+        return -1;
+    }
+
+    Tnum *csa = csaBuffer.get();
+    unsigned short *extStr = extBuffer.get();
+
+    //-------------------------------------------------------------------------
+    // Count runs in BBWT
+    //-------------------------------------------------------------------------
+
+    if (len == 1) {
+        stats.bbwtRuns = 1;
+    }
+    else if (circularSuffixArray(inData, csa, len, lFac, (Tnum) 256, team) == 0) {
+        int prev = -1;
+
+        for (Tnum outPos = 0; outPos < len; ++outPos) {
+            Tnum inPos = csa[outPos];
+
+            // Wrap around the Lyndon factor if needed
+            inPos = lFac[inPos] ? lFac.next(inPos) - 1 : inPos - 1;
+
+            if (inData[inPos] != prev) {
+                prev = inData[inPos];
+                ++stats.bbwtRuns;
+            }
+        }
+    }
+    else {
+        stats.failed = true;
+    }
+
+    //-------------------------------------------------------------------------
+    // Count runs in BWT of inData$. The rotation $inData is a Lyndon word ($ being the smallest character),
+    // so its circular suffix array consists of all rotations of inData$ in lexicographic order.
+    //-------------------------------------------------------------------------
+
+    BitVector<Tnum> single(len + 2);
+
+    single.set(0, true);
+    single.set(len + 1, true);
+    single.buildRankSelect();
+
+    extStr[0] = 0;
+
+    for (Tnum i=0; i<len; ++i)
+        extStr[i + 1] = inData[i] + 1;
+
+    if (circularSuffixArray(extStr, csa, len + 1, single, (Tnum) 257, team) == 0) {
+        int prev = -1;
+
+        for (Tnum outPos = 0; outPos <= len; ++outPos) {
+            Tnum inPos = (csa[outPos] == 0) ? len : csa[outPos] - 1;
+
+            if (extStr[inPos] != prev) {
+                prev = extStr[inPos];
+                ++stats.bwtRuns;
+            }
+        }
+    }
+    else {
+        stats.failed = true;
+    }
+
+
+    return stats.failed ? -1 : 0;
+}
+
+
+/** Maps the file and computes its statistics using the index type appropriate for its size. */
+void fileStats(const string &path, FileStats &stats, unsigned numThreads) {
+    MappedFile inFile;
+
+    if (!inFile.openRead(path.c_str())) {
+        stats.failed = true;
+
+        return;
+    }
+
+    madvise(inFile.data(), inFile.size(), MADV_SEQUENTIAL);
+    stats.size = inFile.size();
+
+    unique_ptr<ThreadTeam> team;
+
+    if (numThreads != 1)
+        team = make_unique<ThreadTeam>(numThreads);
+
+    // The extended string of len + 1 symbols is indexed as well, so keep clear of INT_MAX
+    if (stats.size <= MaxIntLength)
+        computeStats(inFile.data(), (int) stats.size, stats, team.get());
+    else
+        computeStats(inFile.data(), (long) stats.size, stats, team.get());
+}
+
+
+int main(int argc, char **argv) {
+    unsigned numThreads = 0;
+    int opt;
+
+    while ((opt = getopt(argc, argv, "t:")) != -1) {
+        switch (opt) {
+            case 't':
+                numThreads = atoi(optarg);
+                break;
+            default:
+                argc = 0;
+        }
+    }
+
+    if (argc - optind < 1) {
+        cerr << "Usage " << argv[0] << " [-t num_threads] file_or_directory..." << endl;
+
+        return 1;
+    }
+
+    //-------------------------------------------------------------------------
+    // Collect the input files (directories are expanded to their regular files)
+    //-------------------------------------------------------------------------
+
+    vector<FileStats> files;
+
+    for (int i=optind; i<argc; ++i) {
+        error_code ec;
+
+        if (filesystem::is_directory(argv[i], ec)) {
+            vector<string> names;
+
+            for (const auto &entry : filesystem::directory_iterator(argv[i], ec)) {
+                if (entry.is_regular_file(ec))
+                    names.push_back(entry.path().string());
+            }
+
+            sort(names.begin(), names.end());
+
+            for (const string &name : names)
+                files.push_back({name});
+        }
+        else {
+            files.push_back({argv[i]});
+        }
+    }
+
+    //-------------------------------------------------------------------------
+    // A single file is processed with parallel induced sorting,
+    // many files are processed in parallel (one file per thread).
+    //-------------------------------------------------------------------------
+
+    if (files.size() == 1) {
+        fileStats(files[0].name, files[0], numThreads);
+    }
+    else {
+        atomic<size_t> nextFile(0);
+        ThreadTeam team(numThreads);
+
+        team.run([&](unsigned, unsigned) {
+            for (size_t f; (f = nextFile++) < files.size(); )
+                fileStats(files[f].name, files[f], 1);
+        });
+    }
+
+    //-------------------------------------------------------------------------
+
+    int result = 0;
+
+    cout << "| File | S | A | \\#LF | \\#ULF | BBWT | BWT | S / BBWT | S / BWT |" << endl;
+    cout << "|:-----|--:|--:|-----:|------:|-----:|----:|---------:|--------:|" << endl;
+
+    for (const FileStats &stats : files) {
+        if (stats.failed) {
+            cerr << argv[0] << " error: cannot compute statistics of " << stats.name << endl;
+            result = 1;
+
+            continue;
+        }
+
+        cout << "| " << filesystem::path(stats.name).filename().string() << " | " << stats.size << " | " << stats.alphabet
+             << " | " << stats.numFactors << " | " << stats.numUniqueFactors << " | " << stats.bbwtRuns << " | " << stats.bwtRuns
+             << " | " << fixed << setprecision(3) << (double) stats.size / max(stats.bbwtRuns, 1L)
+             << " | " << (double) stats.size / max(stats.bwtRuns, 1L) << " |" << endl;
+    }
+
+    return result;
+}
@@ -0,0 +1,120 @@
+/**
+ * Streaming Bijective Burrows-Wheeler Transform.
+ * Data is read from the standard input and transformed block by block,
+ * the result is written to the standard output, so the tool can be used in pipes.
+ *
+ * (c) 2023 Marcin Piątkowski, marcin.piatkowski(at)mat.umk.pl
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+
+#include <iostream>
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+
+#include <unistd.h>
+
+#include "bbwt_stream.hpp"
+
+using namespace std;
+
+
+/** Reads the standard input in pieces and passes them to the stream encoder or decoder. */
+template<typename Tstream>
+int processStream(Tstream &stream) {
+    vector<unsigned char> buffer(1 << 16);
+    size_t len;
+
+    while ((len = fread(buffer.data(), 1, buffer.size(), stdin)) > 0) {
+        if (stream.write(buffer.data(), len) != 0)
+            return -1;
+    }
+
+    if (ferror(stdin))
+        return -1;
+
+    return stream.finish();
+}
+
+
+int main(int argc, char **argv) {
+    long blockSize = 1L << 20;
+    unsigned numThreads = 1;
+    bool decode = false;
+    int opt;
+
+    while ((opt = getopt(argc, argv, "db:t:")) != -1) {
+        switch (opt) {
+            case 'd':
+                decode = true;
+                break;
+            case 'b':
+                blockSize = atol(optarg) * 1024;
+                break;
+            case 't':
+                numThreads = atoi(optarg);
+                break;
+            default:
+                argc = 0;
+        }
+    }
+
+    if (argc != optind || blockSize <= 0 || blockSize > (1L << 30)) {
+        cerr << "Usage " << argv[0] << " [-d] [-b block_size_KiB] [-t num_threads] < input > output" << endl;
+
+        return 1;
+    }
+
+    //-------------------------------------------------------------------------
+    // Transform (or restore) the standard input block by block
+    //-------------------------------------------------------------------------
+
+    bool written = true;
+
+    auto writeBlock = [&](const unsigned char *block, int len) {
+        written = written && fwrite(block, 1, len, stdout) == (size_t) len;
+    };
+
+    int result;
+
+    if (decode) {
+        BbwtStreamDecoder<> decoder(blockSize, writeBlock, 256, numThreads);
+        result = processStream(decoder);
+    }
+    else {
+        BbwtStreamEncoder<> encoder(blockSize, writeBlock, 256, numThreads);
+        result = processStream(encoder);
+    }
+
+    if (result != 0) {
+        cerr << argv[0] << " error: cannot transform the input stream" << endl;
+
+        return 1;
+    }
+
+    if (fflush(stdout) != 0 || !written) {
+        cerr << argv[0] << " error: cannot write the output stream" << endl;
+
+        return 1;
+    }
+
+    return 0;
+}
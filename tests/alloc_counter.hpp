@@ -0,0 +1,73 @@
+#ifndef _ALLOC_COUNTER_HPP_
+#define _ALLOC_COUNTER_HPP_
+
+/*
+ * Counting replacements of the global operator new and operator delete used by the allocation tests.
+ *
+ * (c) 2023 Marcin Piątkowski, marcin.piatkowski(at)mat.umk.pl
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include <atomic>
+#include <cstdlib>
+#include <new>
+
+#include <malloc.h>
+
+
+/** The number of heap allocations made so far. */
+static std::atomic<size_t> numAllocations(0);
+
+/** The number of bytes currently allocated on the heap and the highest value seen (may be reset by the test). */
+static std::atomic<size_t> heapBytes(0), heapPeak(0);
+
+
+// Not inlined, so that the compiler does not pair malloc() and free() with operator new and delete at the call sites
+__attribute__((noinline)) void *operator new(size_t size) {
+    void *ptr = malloc(size > 0 ? size : 1);
+
+    if (ptr == nullptr)
+        throw std::bad_alloc();
+
+    ++numAllocations;
+
+    size_t bytes = heapBytes += malloc_usable_size(ptr);
+    size_t peak = heapPeak;
+
+    while (bytes > peak && !heapPeak.compare_exchange_weak(peak, bytes));
+
+    return ptr;
+}
+
+
+__attribute__((noinline)) void operator delete(void *ptr) noexcept {
+    if (ptr != nullptr) {
+        heapBytes -= malloc_usable_size(ptr);
+        free(ptr);
+    }
+}
+
+
+__attribute__((noinline)) void operator delete(void *ptr, size_t) noexcept {
+    operator delete(ptr);
+}
+
+
+#endif //_ALLOC_COUNTER_HPP_
@@ -0,0 +1,212 @@
+/**
+ * Effective alphabet and wide symbols testing.
+ * Input data is read from a file and its BBWT computed over the effective alphabet is compared with BBWT
+ * computed over all 256 bytes. Then the input is mapped (preserving the order of symbols) to 16-bit and 32-bit
+ * symbols, and BBWT, the circular suffix array and the inverse of BBWT of the mapped data are compared with
+ * the mapped results for the original data.
+ *
+ * (c) 2023 Marcin Piątkowski, marcin.piatkowski(at)mat.umk.pl
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include <iostream>
+#include <algorithm>
+#include <cstdint>
+#include <vector>
+
+#include "bbwt.hpp"
+#include "MappedFile.hpp"
+
+using namespace std;
+
+
+/** Checks BBWT, the circular suffix array and the inverse of BBWT of the input mapped to symbols of type Tsym.
+ * @return 0 if all results are correct, 1 otherwise
+ */
+template<typename Tsym, typename Tmap>
+int testWideSymbols(const char *name, const unsigned char *inData, const unsigned char *bbwtData, const int *csaData,
+                    int dataSize, Tmap map) {
+    vector<Tsym> mapped(dataSize), transformed(dataSize), restored(dataSize);
+    vector<int> csa(dataSize);
+    int result = 0;
+
+    transform(inData, inData + dataSize, mapped.begin(), map);
+
+    if (bbwt(mapped.data(), transformed.data(), csa.data(), dataSize) != 0
+        || unbbwt(transformed.data(), restored.data(), dataSize) != 0) {
+        cout << "\t" << name << " symbols: computation failed" << endl;
+
+        return 1;
+    }
+
+    if (!equal(bbwtData, bbwtData + dataSize, transformed.begin(), [&](unsigned char c, Tsym s) { return map(c) == s; })) {
+        cout << "\t" << name << " symbols: BBWT differs" << endl;
+        result = 1;
+    }
+
+    if (dataSize > 1 && !equal(csaData, csaData + dataSize, csa.begin())) {
+        cout << "\t" << name << " symbols: circular suffix array differs" << endl;
+        result = 1;
+    }
+
+    if (mapped != restored) {
+        cout << "\t" << name << " symbols: input is not restored correctly" << endl;
+        result = 1;
+    }
+
+    // The circular suffix array alone (wide symbols are ranked in a temporary copy of the input)
+    fill(csa.begin(), csa.end(), 0);
+
+    if (circularSuffixArray(mapped.data(), csa.data(), dataSize) != 0
+        || (dataSize > 1 && !equal(csaData, csaData + dataSize, csa.begin()))) {
+        cout << "\t" << name << " symbols: circularSuffixArray() differs" << endl;
+        result = 1;
+    }
+
+    return result;
+}
+
+
+/** Checks BBWT, the circular suffix array and the inverse of BBWT of the input mapped to signed symbols of type Tsym
+ * (including negative ones, which are never used as bucket indices directly).
+ * @return 0 if all results are correct, 1 otherwise
+ */
+template<typename Tsym, typename Tmap>
+int testSignedSymbols(const char *name, const unsigned char *inData, const unsigned char *bbwtData, const int *csaData,
+                      int dataSize, Tmap map) {
+    vector<Tsym> mapped(dataSize), transformed(dataSize), restored(dataSize);
+    vector<int> csa(dataSize);
+    int result = 0;
+
+    transform(inData, inData + dataSize, mapped.begin(), map);
+
+    if (bbwt(mapped.data(), transformed.data(), csa.data(), dataSize) != 0
+        || !equal(bbwtData, bbwtData + dataSize, transformed.begin(), [&](unsigned char c, Tsym s) { return map(c) == s; })) {
+        cout << "\t" << name << " symbols: BBWT differs" << endl;
+        result = 1;
+    }
+
+    transform(bbwtData, bbwtData + dataSize, transformed.begin(), map);
+
+    if (circularSuffixArray(mapped.data(), csa.data(), dataSize) != 0
+        || (dataSize > 1 && !equal(csaData, csaData + dataSize, csa.begin()))) {
+        cout << "\t" << name << " symbols: circularSuffixArray() differs" << endl;
+        result = 1;
+    }
+
+    if (unbbwt(transformed.data(), restored.data(), dataSize) != 0 || mapped != restored) {
+        cout << "\t" << name << " symbols: input is not restored correctly" << endl;
+        result = 1;
+    }
+
+    return result;
+}
+
+
+int main(int argc, char **argv) {
+    MappedFile inFile;
+
+    if(argc != 2) {
+        cerr << "Usage " << argv[0] << " input_file" << endl;
+
+        return 1;
+    }
+
+    if (!inFile.openRead(argv[1])) {
+        cerr << argv[0] << " error: cannot read input file " << argv[1] << endl;
+
+        return 1;
+    }
+
+    const unsigned char *inData = inFile.data();
+    int dataSize = inFile.size();
+
+    cout << "-- Input size = " << dataSize << " B --" << endl;
+
+    if (dataSize == 0) {
+        cout << "-- Finished --" << endl;
+
+        return 0;
+    }
+
+    //-------------------------------------------------------------------------
+    // Bytes: the effective alphabet against all 256 symbols (also in place)
+    //-------------------------------------------------------------------------
+
+    vector<unsigned char> expected(dataSize), transformed(dataSize), restored(dataSize);
+    vector<int> expectedCsa(dataSize), csa(dataSize);
+    int result = 0;
+
+    if (bbwt(inData, expected.data(), expectedCsa.data(), dataSize, 256) != 0
+        || bbwt(inData, transformed.data(), csa.data(), dataSize) != 0
+        || unbbwt(transformed.data(), restored.data(), dataSize) != 0) {
+        cerr << argv[0] << " error: cannot compute BBWT" << endl;
+
+        return 1;
+    }
+
+    if (expected != transformed) {
+        cout << "\tBBWT over the effective alphabet differs" << endl;
+        result = 1;
+    }
+
+    if (dataSize > 1 && expectedCsa != csa) {
+        cout << "\tcircular suffix array over the effective alphabet differs" << endl;
+        result = 1;
+    }
+
+    if (!equal(inData, inData + dataSize, restored.begin())) {
+        cout << "\tinput is not restored correctly" << endl;
+        result = 1;
+    }
+
+    copy(inData, inData + dataSize, transformed.begin());
+
+    if (bbwt(transformed.data(), transformed.data(), csa.data(), dataSize) != 0 || expected != transformed) {
+        cout << "\tBBWT computed in place over the effective alphabet differs" << endl;
+        result = 1;
+    }
+
+    //-------------------------------------------------------------------------
+    // Wide symbols
+    //-------------------------------------------------------------------------
+
+    result |= testWideSymbols<uint16_t>("16-bit", inData, expected.data(), expectedCsa.data(), dataSize,
+                                        [](unsigned char c) { return (uint16_t) (c * 251 + 1000); });
+
+    result |= testWideSymbols<uint32_t>("32-bit", inData, expected.data(), expectedCsa.data(), dataSize,
+                                        [](unsigned char c) { return (uint32_t) (c * 16777259U + 7); });
+
+    //-------------------------------------------------------------------------
+    // Negative symbols (small ones would fit into the direct bucket table if they were not negative)
+    //-------------------------------------------------------------------------
+
+    result |= testSignedSymbols<int32_t>("small signed", inData, expected.data(), expectedCsa.data(), dataSize,
+                                         [](unsigned char c) { return (int32_t) c - 128; });
+
+    result |= testSignedSymbols<int64_t>("wide signed", inData, expected.data(), expectedCsa.data(), dataSize,
+                                         [](unsigned char c) { return (int64_t) c * 1000003 - 100000000; });
+
+    cout << "-- Finished --" << endl;
+
+    //-------------------------------------------------------------------------
+
+    return result;
+}
@@ -0,0 +1,92 @@
+/**
+ * Block compression testing.
+ * Input data is read from a file, then it is compressed and decompressed
+ * block by block for several block sizes and compared to the input data.
+ *
+ * (c) 2023 Marcin Piątkowski, marcin.piatkowski(at)mat.umk.pl
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include <iostream>
+#include <cstdio>
+#include <cstring>
+#include <algorithm>
+#include <vector>
+
+#include "bbwt_compress.hpp"
+#include "MappedFile.hpp"
+
+using namespace std;
+
+
+int main(int argc, char **argv) {
+    MappedFile inFile;
+
+    if(argc != 2) {
+        cerr << "Usage " << argv[0] << " input_file" << endl;
+
+        return 1;
+    }
+
+    if (!inFile.openRead(argv[1])) {
+        cerr << argv[0] << " error: cannot read input file " << argv[1] << endl;
+
+        return 1;
+    }
+
+    const unsigned char *inData = inFile.data();
+    size_t dataSize = inFile.size();
+
+    cout << "-- Input size = " << dataSize << " B --" << endl;
+
+    //-------------------------------------------------------------------------
+    // Compress and decompress the data using blocks of different sizes
+    //-------------------------------------------------------------------------
+
+    int result = 0;
+    BlockWorkspace ws;
+    vector<unsigned char> compressed;
+    vector<unsigned char> outData(DefaultBlockSize);
+
+    for (size_t blockSize : {(size_t) 1, (size_t) 1000, (size_t) 65536, (size_t) DefaultBlockSize}) {
+        size_t totalSize = 0;
+
+        for (size_t blockStart=0; blockStart<dataSize; blockStart+=blockSize) {
+            int blockLen = min(blockSize, dataSize - blockStart);
+
+            if (compressBlock(inData + blockStart, blockLen, compressed, ws) != 0
+                || decompressBlock(compressed.data(), compressed.size(), outData.data(), blockLen, ws) != 0
+                || memcmp(inData + blockStart, outData.data(), blockLen) != 0) {
+                cout << "\tblock size " << blockSize << ": block at " << blockStart << " differs" << endl;
+                result = 1;
+            }
+
+            totalSize += compressed.size();
+        }
+
+        cout << "-- Block size " << blockSize << ": " << totalSize << " B --" << endl;
+    }
+
+    cout << "-- Finished --" << endl;
+
+    //-------------------------------------------------------------------------
+
+    return result;
+}
@@ -1,7 +1,7 @@
 /**
  * Bijective Burrows-Wheeler Transform computation example.
- * Input data is read from the standard input,
- * then BBWT and its inversion are computed.
+ * Input data is read from the standard input (each line is a separate record),
+ * then BBWT and its inversion are computed for each record and the inversion is compared to the record.
  *
  * (c) 2023 Marcin Piątkowski, marcin.piatkowski(at)mat.umk.pl
  *
@@ -24,34 +24,62 @@
  * SOFTWARE.
  */
 
-#include <cstdio>
-#include <cstring>
 
-#include "bbwt.hpp"
+#include <iostream>
+#include <algorithm>
+#include <cstdlib>
+#include <string>
+#include <vector>
+
+#include "bbwt_records.hpp"
 
 using namespace std;
 using Tnum = int;
 
 
-const int MaxDataSize = 2048;
+/** Appends BBWT and its inverse of the record to ws.output. */
+int testRecord(const unsigned char *record, Tnum len, RecordWorkspace<Tnum> &ws) {
+    static const string BbwtLabel = "BBWT  > ", UnbbwtLabel = "\nUNBBWT> ";
+
+    ws.output.insert(ws.output.end(), BbwtLabel.begin(), BbwtLabel.end());
+
+    if (bbwtRecord(record, len, ws) != 0)
+        return -1;
+
+    vector<unsigned char> transformed(ws.output.end() - len, ws.output.end());
+
+    ws.output.insert(ws.output.end(), UnbbwtLabel.begin(), UnbbwtLabel.end());
+    size_t offset = ws.output.size();
+
+    if (unbbwtRecord(transformed.data(), len, ws) != 0)
+        return -1;
+
+    if (!equal(record, record + len, ws.output.begin() + offset)) {
+        cerr << "\tthe inverse of BBWT differs from the input record" << endl;
 
+        return -1;
+    }
+
+    ws.output.push_back('\n');
 
-int main() {
-    unsigned char inData[MaxDataSize], bbwtData[MaxDataSize], outData[MaxDataSize];
-    Tnum csa[MaxDataSize];
+    return 0;
+}
 
-    printf("INPUT > ");
 
-    while (fgets((char *)inData, MaxDataSize, stdin)) {
-        Tnum len = strlen((char *)inData) - 1;
-        inData[len] = bbwtData[len] = outData[len] = '\0';
+int main(int argc, char **argv) {
+    if(argc > 2) {
+        cerr << "Usage " << argv[0] << " [num_threads] < input" << endl;
+
+        return 1;
+    }
+
+    unsigned numThreads = (argc == 2) ? atoi(argv[1]) : 0;
+    BbwtRecordProcessor<Tnum> processor(testRecord, numThreads);
 
-        bbwt(inData, bbwtData, csa, len);
-        printf("BBWT  > %s\n", bbwtData);
-        unbbwt(bbwtData, outData, len);
-        printf("UNBBWT> %s\n", outData);
+    if (processor.run() != 0) {
+        cerr << argv[0] << " error: test failed" << endl;
 
-        printf("\nINPUT > ");
+        return 1;
     }
 
     return 0;
@@ -0,0 +1,153 @@
+/**
+ * External-memory BBWT testing.
+ * Reads data from a given file, computes its BBWT in memory with bbwt() and with bbwtExternal()
+ * for several memory budgets (the smallest ones force multi-pass external sorting) and compares the results.
+ *
+ * (c) 2023 Marcin Piątkowski, marcin.piatkowski(at)mat.umk.pl
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include <iostream>
+#include <algorithm>
+#include <cstdlib>
+#include <string>
+#include <vector>
+
+#include <sys/resource.h>
+#include <unistd.h>
+
+#include "bbwt.hpp"
+#include "bbwt_external.hpp"
+#include "MappedFile.hpp"
+
+using namespace std;
+
+
+/** The limit of open files of the last computation (the standard streams and a few temporary files). */
+const size_t MaxOpenFiles = 16;
+
+
+int main(int argc, char **argv) {
+    MappedFile inFile;
+
+    if(argc != 2) {
+        cerr << "Usage " << argv[0] << " input_file" << endl;
+
+        return 1;
+    }
+
+    if (!inFile.openRead(argv[1])) {
+        cerr << argv[0] << " error: cannot read input file " << argv[1] << endl;
+
+        return 1;
+    }
+
+    const unsigned char *inData = inFile.data();
+    long dataSize = inFile.size();
+
+    cout << "-- Input size = " << dataSize << " B --" << endl;
+
+    //-------------------------------------------------------------------------
+    // Compute BBWT in memory
+    //-------------------------------------------------------------------------
+
+    vector<unsigned char> bbwtData(dataSize);
+    vector<long> csa(dataSize);
+
+    if (dataSize > 0 && bbwt(inData, bbwtData.data(), csa.data(), dataSize) != 0) {
+        cerr << argv[0] << " error: BBWT computation failed" << endl;
+
+        return 1;
+    }
+
+    //-------------------------------------------------------------------------
+    // Compute BBWT in external memory and compare the results
+    //-------------------------------------------------------------------------
+
+    const char *tmpDir = getenv("TMPDIR");
+    string outPath = string((tmpDir != nullptr && *tmpDir != '\0') ? tmpDir : "/tmp") + "/bbwt-external-test-XXXXXX";
+    int outFd = mkstemp(outPath.data());
+
+    if (outFd < 0) {
+        cerr << argv[0] << " error: cannot create output file " << outPath << endl;
+
+        return 1;
+    }
+
+    close(outFd);
+
+    int result = 0;
+
+    for (size_t memory : {MinExternalMemory, (size_t) 1 << 20, (size_t) 1 << 26}) {
+        cout << "-- Computing BBWT with " << (memory >> 10) << " KiB of memory --" << endl;
+
+        MappedFile outFile;
+
+        if (bbwtExternal(argv[1], outPath.c_str(), memory) != 0 || !outFile.openRead(outPath.c_str())) {
+            cerr << argv[0] << " error: external BBWT computation failed" << endl;
+            result = 1;
+            break;
+        }
+
+        if (outFile.size() != (size_t) dataSize || !equal(bbwtData.begin(), bbwtData.end(), outFile.data())) {
+            cout << "\texternal BBWT differs from BBWT computed in memory" << endl;
+            result = 1;
+        }
+    }
+
+    //-------------------------------------------------------------------------
+    // The smallest memory budget creates many runs, which must not need a file descriptor each
+    //-------------------------------------------------------------------------
+
+    struct rlimit limit;
+
+    if (result == 0 && getrlimit(RLIMIT_NOFILE, &limit) == 0) {
+        struct rlimit lowered = limit;
+
+        lowered.rlim_cur = std::min(limit.rlim_cur, (rlim_t) MaxOpenFiles);
+        cout << "-- Computing BBWT with " << (MinExternalMemory >> 10) << " KiB of memory and at most "
+             << lowered.rlim_cur << " open files --" << endl;
+
+        MappedFile outFile;
+
+        if (setrlimit(RLIMIT_NOFILE, &lowered) != 0) {
+            cerr << argv[0] << " error: cannot limit the number of open files" << endl;
+            result = 1;
+        }
+        else if (bbwtExternal(argv[1], outPath.c_str(), MinExternalMemory) != 0 || !outFile.openRead(outPath.c_str())) {
+            cout << "\texternal BBWT computation failed with limited open files" << endl;
+            result = 1;
+        }
+        else if (outFile.size() != (size_t) dataSize || !equal(bbwtData.begin(), bbwtData.end(), outFile.data())) {
+            cout << "\texternal BBWT with limited open files differs from BBWT computed in memory" << endl;
+            result = 1;
+        }
+
+        setrlimit(RLIMIT_NOFILE, &limit);
+    }
+
+    unlink(outPath.c_str());
+
+    cout << "-- Finished --" << endl;
+
+    //-------------------------------------------------------------------------
+
+    return result;
+}
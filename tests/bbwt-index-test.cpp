@@ -0,0 +1,145 @@
+/**
+ * BBWT index testing.
+ * Reads data from a given file, builds BbwtIndex over its BBWT and compares the results of count and locate
+ * queries with a naive search of circular occurrences in the Lyndon factors. Patterns are taken from the input
+ * (including patterns wrapping around their Lyndon factors many times) or consist of random symbols.
+ *
+ * (c) 2023 Marcin Piątkowski, marcin.piatkowski(at)mat.umk.pl
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include <iostream>
+#include <algorithm>
+#include <random>
+#include <vector>
+
+#include "bbwt.hpp"
+#include "bbwt_index.hpp"
+#include "MappedFile.hpp"
+
+using namespace std;
+
+
+int main(int argc, char **argv) {
+    MappedFile inFile;
+
+    if(argc != 2) {
+        cerr << "Usage " << argv[0] << " input_file" << endl;
+
+        return 1;
+    }
+
+    if (!inFile.openRead(argv[1])) {
+        cerr << argv[0] << " error: cannot read input file " << argv[1] << endl;
+
+        return 1;
+    }
+
+    const unsigned char *inData = inFile.data();
+    int dataSize = inFile.size();
+
+    cout << "-- Input size = " << dataSize << " B --" << endl;
+
+    if (dataSize == 0) {
+        cout << "-- Finished --" << endl;
+
+        return 0;
+    }
+
+    //-------------------------------------------------------------------------
+    // Build the index and find the Lyndon factor of every position
+    //-------------------------------------------------------------------------
+
+    vector<unsigned char> bbwtData(dataSize);
+    vector<int> csa(dataSize);
+
+    if (bbwt(inData, bbwtData.data(), csa.data(), dataSize) != 0) {
+        cerr << argv[0] << " error: cannot compute BBWT" << endl;
+
+        return 1;
+    }
+
+    BbwtIndex<unsigned char, int> index(inData, bbwtData.data(), csa.data(), dataSize, 16);
+
+    cout << "\tindex size = " << index.memoryUsage() << " B" << endl;
+
+    BitVector<int> lFac(dataSize + 1);
+    vector<int> factorStart(dataSize), factorLen(dataSize);
+
+    lyndonFactors(inData, dataSize, &lFac);
+
+    for (int start = 0; start < dataSize; ) {
+        int end = lFac.next(start);
+
+        fill(factorStart.begin() + start, factorStart.begin() + end, start);
+        fill(factorLen.begin() + start, factorLen.begin() + end, end - start);
+        start = end;
+    }
+
+    //-------------------------------------------------------------------------
+    // Compare queries with the naive search
+    //-------------------------------------------------------------------------
+
+    mt19937 gen(dataSize);
+    int result = 0;
+
+    for (int q = 0; q < 64; ++q) {
+        int pos = gen() % dataSize;
+        int m = (q % 4 == 3) ? factorLen[pos] + 1 + gen() % 8 : 1 + gen() % 12;
+        vector<unsigned char> pattern(m);
+
+        // Read the pattern circularly in the Lyndon factor, or take random symbols
+        for (int j = 0; j < m; ++j) {
+            int k = pos - factorStart[pos] + j;
+
+            pattern[j] = (q % 8 == 5) ? gen() % 256 : inData[factorStart[pos] + k % factorLen[pos]];
+        }
+
+        vector<int> expected;
+
+        for (int p = 0; p < dataSize; ++p) {
+            int j = 0;
+
+            while (j < m && inData[factorStart[p] + (p - factorStart[p] + j) % factorLen[p]] == pattern[j])
+                ++j;
+
+            if (j == m)
+                expected.push_back(p);
+        }
+
+        vector<int> positions;
+        int count = index.count(pattern.data(), m);
+
+        index.locate(pattern.data(), m, positions);
+        sort(positions.begin(), positions.end());
+
+        if (count != (int) expected.size() || positions != expected) {
+            cout << "\tquery " << q << " (length " << m << "): " << count << " occurrence(s) instead of "
+                 << expected.size() << endl;
+            result = 1;
+        }
+    }
+
+    cout << "-- Finished --" << endl;
+
+    //-------------------------------------------------------------------------
+
+    return result;
+}
@@ -0,0 +1,121 @@
+/**
+ * Working memory testing.
+ * Input data is read from a file and its BBWT is computed with a fresh workspace. Apart from the suffix array buffer,
+ * the computation may use only bit vectors (O(n) bits) and buckets, so the peak of the heap memory allocated during
+ * the computation (counted by the replaced operator new, without buckets) has to stay below MaxBitsPerChar bits
+ * per input character.
+ *
+ * (c) 2023 Marcin Piątkowski, marcin.piatkowski(at)mat.umk.pl
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include <iostream>
+#include <algorithm>
+#include <vector>
+
+#include "bbwt.hpp"
+#include "MappedFile.hpp"
+#include "alloc_counter.hpp"
+
+using namespace std;
+using Tnum = int;
+
+
+/** The bound on the working memory (without buckets) per input character. */
+const size_t MaxBitsPerChar = 8;
+
+/** Constant overhead (bit vector padding, rank/select directories of short inputs, alphabet-sized arrays of the workspace). */
+const size_t MaxConstBytes = 8192;
+
+
+int main(int argc, char **argv) {
+    MappedFile inFile;
+
+    if(argc != 2) {
+        cerr << "Usage " << argv[0] << " input_file" << endl;
+
+        return 1;
+    }
+
+    if (!inFile.openRead(argv[1])) {
+        cerr << argv[0] << " error: cannot read input file " << argv[1] << endl;
+
+        return 1;
+    }
+
+    const unsigned char *inData = inFile.data();
+    Tnum dataSize = inFile.size();
+
+    cout << "-- Input size = " << dataSize << " B --" << endl;
+
+    if (dataSize == 0) {
+        cout << "-- Finished --" << endl;
+
+        return 0;
+    }
+
+    //-------------------------------------------------------------------------
+    // Compute BBWT with a fresh workspace and measure the peak of the heap memory allocated meanwhile
+    //-------------------------------------------------------------------------
+
+    vector<unsigned char> bbwtData(dataSize), outData(dataSize);
+    vector<Tnum> csa(dataSize);
+
+    size_t baseBytes = heapPeak = heapBytes.load();
+    BbwtWorkspace<Tnum> ws;
+
+    if (bbwt(inData, bbwtData.data(), csa.data(), dataSize, ws) != 0) {
+        cerr << argv[0] << " error: BBWT computation failed" << endl;
+
+        return 1;
+    }
+
+    size_t peakBytes = heapPeak - baseBytes;
+
+    if (unbbwt(bbwtData.data(), outData.data(), dataSize) != 0) {
+        cerr << argv[0] << " error: BBWT computation failed" << endl;
+
+        return 1;
+    }
+
+    size_t bucketBytes = ws.bucketsMemoryUsage();
+    size_t workBytes = peakBytes - min(peakBytes, bucketBytes);
+    size_t maxBytes = MaxBitsPerChar * dataSize / 8 + MaxConstBytes;
+    int result = 0;
+
+    cout << "-- Working memory = " << workBytes << " B (" << 8.0 * workBytes / dataSize << " bits per character)"
+         << ", buckets = " << bucketBytes << " B, workspace = " << ws.memoryUsage() << " B --" << endl;
+
+    if (workBytes > maxBytes) {
+        cout << "\tworking memory exceeds " << maxBytes << " B" << endl;
+        result = 1;
+    }
+
+    if (!equal(outData.begin(), outData.end(), inData)) {
+        cout << "\tthe inverse of BBWT differs from the input data" << endl;
+        result = 1;
+    }
+
+    cout << "-- Finished --" << endl;
+
+    //-------------------------------------------------------------------------
+
+    return result;
+}
@@ -0,0 +1,106 @@
+/**
+ * Run-length encoded BBWT testing.
+ * Reads data from a given file, computes its run-length encoded BBWT in compressed space and compares
+ * the expanded runs to BBWT computed with bbwt(). Runs have to be maximal (adjacent runs differ in symbols).
+ *
+ * (c) 2023 Marcin Piątkowski, marcin.piatkowski(at)mat.umk.pl
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include <iostream>
+#include <vector>
+
+#include "bbwt.hpp"
+#include "bbwt_runlength.hpp"
+#include "MappedFile.hpp"
+
+using namespace std;
+
+
+int main(int argc, char **argv) {
+    MappedFile inFile;
+
+    if(argc != 2) {
+        cerr << "Usage " << argv[0] << " input_file" << endl;
+
+        return 1;
+    }
+
+    if (!inFile.openRead(argv[1])) {
+        cerr << argv[0] << " error: cannot read input file " << argv[1] << endl;
+
+        return 1;
+    }
+
+    const unsigned char *inData = inFile.data();
+    long dataSize = inFile.size();
+
+    cout << "-- Input size = " << dataSize << " B --" << endl;
+
+    //-------------------------------------------------------------------------
+    // Compute BBWT in both ways
+    //-------------------------------------------------------------------------
+
+    vector<unsigned char> expected(dataSize);
+    vector<long> csa(dataSize);
+    vector<BbwtRun<unsigned char, long>> runs;
+    size_t memoryUsage = 0;
+
+    if ((dataSize > 0 && bbwt(inData, expected.data(), csa.data(), dataSize, 256L) != 0)
+        || bbwtRunLength(inData, dataSize, runs, 256L, &memoryUsage) != 0) {
+        cerr << argv[0] << " error: cannot compute BBWT" << endl;
+
+        return 1;
+    }
+
+    cout << "\truns = " << runs.size() << ", working memory = " << memoryUsage << " B" << endl;
+
+    //-------------------------------------------------------------------------
+    // Compare the results
+    //-------------------------------------------------------------------------
+
+    long pos = 0;
+    int result = 0;
+
+    for (size_t i = 0; i < runs.size() && result == 0; ++i) {
+        if (runs[i].length <= 0 || (i > 0 && runs[i].symbol == runs[i - 1].symbol)) {
+            cout << "\trun " << i << " is not maximal" << endl;
+            result = 1;
+        }
+
+        for (long j = 0; j < runs[i].length && result == 0; ++j, ++pos) {
+            if (pos >= dataSize || expected[pos] != runs[i].symbol) {
+                cout << "\tBBWT differs at position " << pos << endl;
+                result = 1;
+            }
+        }
+    }
+
+    if (result == 0 && pos != dataSize) {
+        cout << "\tBBWT is too short (" << pos << " B)" << endl;
+        result = 1;
+    }
+
+    cout << "-- Finished --" << endl;
+
+    //-------------------------------------------------------------------------
+
+    return result;
+}
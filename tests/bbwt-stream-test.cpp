@@ -0,0 +1,159 @@
+/**
+ * Streaming transform testing.
+ * Input data is read from a file and fed to the stream encoder in pieces of varying size.
+ * Each emitted block is compared to the BBWT of the corresponding input block,
+ * then the transformed stream is decoded and compared to the input data.
+ *
+ * (c) 2023 Marcin Piątkowski, marcin.piatkowski(at)mat.umk.pl
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+
+#include <iostream>
+#include <cstdio>
+#include <cstring>
+#include <algorithm>
+#include <cstdint>
+#include <vector>
+
+#include "bbwt_stream.hpp"
+#include "MappedFile.hpp"
+
+using namespace std;
+
+
+/** Transforms and restores the input mapped to symbols of type Tsym with the default (effective) alphabet
+ * and compares the transformed stream with the mapped stream of bytes.
+ * @return 0 if all results are correct, 1 otherwise
+ */
+template<typename Tsym, typename Tmap>
+int testWideSymbols(const char *name, const unsigned char *inData, const vector<unsigned char> &transformed,
+                    int blockSize, Tmap map) {
+    vector<Tsym> mapped(transformed.size()), mappedTransformed, restored;
+    int result = 0;
+
+    transform(inData, inData + mapped.size(), mapped.begin(), map);
+
+    BbwtStreamEncoder<Tsym> encoder(blockSize, [&](const Tsym *block, int len) {
+        mappedTransformed.insert(mappedTransformed.end(), block, block + len);
+    });
+
+    BbwtStreamDecoder<Tsym> decoder(blockSize, [&](const Tsym *block, int len) {
+        restored.insert(restored.end(), block, block + len);
+    });
+
+    if (encoder.write(mapped.data(), mapped.size()) != 0 || encoder.finish() != 0
+        || mappedTransformed.size() != transformed.size()
+        || !equal(transformed.begin(), transformed.end(), mappedTransformed.begin(), [&](unsigned char c, Tsym s) { return map(c) == s; })) {
+        cout << "\tblock size " << blockSize << ": transformed stream of " << name << " symbols differs" << endl;
+        result = 1;
+    }
+
+    if (decoder.write(mappedTransformed.data(), mappedTransformed.size()) != 0 || decoder.finish() != 0 || restored != mapped) {
+        cout << "\tblock size " << blockSize << ": restored stream of " << name << " symbols differs" << endl;
+        result = 1;
+    }
+
+    return result;
+}
+
+
+int main(int argc, char **argv) {
+    MappedFile inFile;
+
+    if(argc != 2) {
+        cerr << "Usage " << argv[0] << " input_file" << endl;
+
+        return 1;
+    }
+
+    if (!inFile.openRead(argv[1])) {
+        cerr << argv[0] << " error: cannot read input file " << argv[1] << endl;
+
+        return 1;
+    }
+
+    const unsigned char *inData = inFile.data();
+    size_t dataSize = inFile.size();
+
+    cout << "-- Input size = " << dataSize << " B --" << endl;
+
+    //-------------------------------------------------------------------------
+    // Transform and restore the data using blocks of different sizes
+    //-------------------------------------------------------------------------
+
+    int result = 0;
+
+    for (int blockSize : {1, 7, 1000, 65536, 1 << 22}) {
+        vector<unsigned char> transformed;
+        vector<unsigned char> restored;
+        vector<unsigned char> expected(blockSize);
+        vector<int> csa(blockSize);
+        bool blocksOk = true;
+
+        BbwtStreamEncoder<> encoder(blockSize, [&](const unsigned char *block, int len) {
+            size_t blockStart = transformed.size();
+
+            bbwt(inData + blockStart, expected.data(), csa.data(), len);
+            blocksOk = blocksOk && memcmp(block, expected.data(), len) == 0;
+            transformed.insert(transformed.end(), block, block + len);
+        });
+
+        BbwtStreamDecoder<> decoder(blockSize, [&](const unsigned char *block, int len) {
+            restored.insert(restored.end(), block, block + len);
+        });
+
+        // Feed the data in pieces which are not aligned to the block size
+        for (size_t pos=0, piece=1; pos<dataSize; pos+=piece, piece=piece*3+1) {
+            piece = min(piece, dataSize - pos);
+
+            if (encoder.write(inData + pos, piece) != 0)
+                result = 1;
+        }
+
+        if (encoder.finish() != 0 || transformed.size() != dataSize || !blocksOk) {
+            cout << "\tblock size " << blockSize << ": transformed stream differs" << endl;
+            result = 1;
+        }
+
+        if (decoder.write(transformed.data(), transformed.size()) != 0 || decoder.finish() != 0
+            || restored.size() != dataSize || !equal(restored.begin(), restored.end(), inData)) {
+            cout << "\tblock size " << blockSize << ": restored stream differs" << endl;
+            result = 1;
+        }
+
+        // Wide symbols are mapped to the effective alphabet of every block
+        if (blockSize > 1) {
+            result |= testWideSymbols<uint16_t>("16-bit", inData, transformed, blockSize,
+                                                [](unsigned char c) { return (uint16_t) (c * 251 + 1000); });
+
+            result |= testWideSymbols<uint32_t>("32-bit", inData, transformed, blockSize,
+                                                [](unsigned char c) { return (uint32_t) (c * 16777259U + 7); });
+        }
+
+        cout << "-- Block size " << blockSize << " --" << endl;
+    }
+
+    cout << "-- Finished --" << endl;
+
+    //-------------------------------------------------------------------------
+
+    return result;
+}
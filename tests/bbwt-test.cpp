@@ -27,6 +27,7 @@
 #include <iostream>
 #include <iomanip>
 #include <cstdio>
+#include <cstdlib>
 #include <chrono>
 #include <new>
 
@@ -43,12 +44,14 @@ int main(int argc, char **argv) {
     Tnum *csa = nullptr;
     FILE *inFile;
 
-    if(argc != 2) {
-        cerr << "Usage " << argv[0] << " input_file" << endl;
+    if(argc != 2 && argc != 3) {
+        cerr << "Usage " << argv[0] << " input_file [num_threads]" << endl;
 
         return 1;
     }
 
+    unsigned numThreads = (argc == 3) ? atoi(argv[2]) : 1;
+
     //-------------------------------------------------------------------------
     // Read data from the input file
     //-------------------------------------------------------------------------
@@ -87,9 +90,10 @@ int main(int argc, char **argv) {
     //-------------------------------------------------------------------------
 
     cout << "-- Computing BBWT --" << endl;
+    BbwtStats stats;
     auto start = chrono::high_resolution_clock::now();
 
-    if (bbwt(inData, bbwtData, csa, dataSize) != 0) {
+    if (bbwt(inData, bbwtData, csa, dataSize, 256, numThreads, &stats) != 0) {
         cerr << argv[0] << " error: BBWT computation failed" << endl;
 
         return -1;
@@ -98,7 +102,41 @@ int main(int argc, char **argv) {
     auto end = chrono::high_resolution_clock::now();
     auto duration = chrono::duration_cast<chrono::milliseconds>(end - start);
 
-    cout << "-- Runtime " << duration.count()/1000 << "." << fixed << setprecision(3) << duration.count()%1000 << " s --" << endl;
+    cout << "-- Runtime " << duration.count()/1000 << "." << setfill('0') << setw(3) << duration.count()%1000 << " s --" << endl;
+    stats.report(cout);
+
+    //-------------------------------------------------------------------------
+    // Compute BBWT with 64-bit indices and the suffix array packed into 40-bit entries,
+    // the result has to be the same
+    //-------------------------------------------------------------------------
+
+    cout << "-- Computing BBWT with 40-bit suffix array --" << endl;
+
+    Int40 *packedCsa = nullptr;
+
+    try {
+        packedCsa = new Int40[dataSize];
+    }
+    catch (const bad_alloc &e) {
+        cerr << argv[0] << ": Memory allocation error" << endl;
+
+        return 2;
+    }
+
+    if (bbwt(inData, outData, packedCsa, (long) dataSize, 256L, numThreads) != 0) {
+        cerr << argv[0] << " error: BBWT computation failed" << endl;
+
+        return -1;
+    }
+
+    for (Tnum pos=0; pos < dataSize; ++pos) {
+        if (bbwtData[pos] != outData[pos]) {
+            cout << "\t" << pos << ": BBWT computed with 40-bit suffix array differs" << endl;
+            break;
+        }
+    }
+
+    delete[] packedCsa;
 
 
     //-------------------------------------------------------------------------
@@ -107,7 +145,7 @@ int main(int argc, char **argv) {
 
     cout << "-- Computing BBWT inversion --" << endl;
 
-    if (unbbwt(bbwtData, outData,dataSize) != 0) {
+    if (unbbwt(bbwtData, outData, dataSize, 256, numThreads) != 0) {
         cerr << argv[0] << " error: inverse BBWT computation failed" << endl;
 
         return -1;
@@ -0,0 +1,147 @@
+/**
+ * Reusable workspace testing.
+ * Input data is read from a file and each line is treated as a separate record. All records are transformed
+ * with a single BbwtWorkspace (in the original order and then from the longest to the shortest one, so that
+ * the buffers are both grown and reused) and the results are compared with bbwt() and unbbwt() without workspace.
+ * Heap allocations are counted as well: once the buffers have been grown, reusing the workspace must not allocate.
+ *
+ * (c) 2023 Marcin Piątkowski, marcin.piatkowski(at)mat.umk.pl
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include <iostream>
+#include <algorithm>
+#include <vector>
+
+#include "bbwt.hpp"
+#include "MappedFile.hpp"
+#include "alloc_counter.hpp"
+
+using namespace std;
+
+
+int main(int argc, char **argv) {
+    MappedFile inFile;
+
+    if(argc != 2) {
+        cerr << "Usage " << argv[0] << " input_file" << endl;
+
+        return 1;
+    }
+
+    if (!inFile.openRead(argv[1])) {
+        cerr << argv[0] << " error: cannot read input file " << argv[1] << endl;
+
+        return 1;
+    }
+
+    const unsigned char *inData = inFile.data();
+    int dataSize = inFile.size();
+
+    //-------------------------------------------------------------------------
+    // Split the input into lines (line separators are kept at the end of lines)
+    //-------------------------------------------------------------------------
+
+    vector<int> starts, lengths;
+    int maxLen = 0;
+
+    for (int start=0, pos=0; pos<dataSize; ++pos) {
+        if (inData[pos] == '\n' || pos == dataSize - 1) {
+            starts.push_back(start);
+            lengths.push_back(pos + 1 - start);
+            maxLen = max(maxLen, pos + 1 - start);
+            start = pos + 1;
+        }
+    }
+
+    cout << "-- Input size = " << dataSize << " B, " << lengths.size() << " record(s) --" << endl;
+
+    // Records in the original order followed by all records from the longest to the shortest one
+    int numRecords = lengths.size();
+    vector<int> order(2 * numRecords);
+
+    for (int i=0; i<numRecords; ++i)
+        order[i] = order[numRecords + i] = i;
+
+    stable_sort(order.begin() + numRecords, order.end(), [&](int a, int b) { return lengths[a] > lengths[b]; });
+
+    //-------------------------------------------------------------------------
+    // Transform all records with a single workspace
+    //-------------------------------------------------------------------------
+
+    BbwtWorkspace<int> ws;
+    vector<unsigned char> expected(maxLen), transformed(maxLen), restored(maxLen);
+    vector<int> csa(maxLen);
+    int result = 0;
+
+    for (int k=0; k<2*numRecords; ++k) {
+        int i = order[k];
+        const unsigned char *record = inData + starts[i];
+        int len = lengths[i];
+
+        if (bbwt(record, expected.data(), csa.data(), len) != 0) {
+            cerr << argv[0] << " error: cannot compute BBWT of record " << i << endl;
+
+            return 1;
+        }
+
+        size_t before = numAllocations;
+        int transformResult = bbwt(record, transformed.data(), csa.data(), len, ws);
+        size_t transformAllocations = numAllocations - before;
+
+        before = numAllocations;
+        int restoreResult = unbbwt(transformed.data(), restored.data(), len, ws);
+        size_t restoreAllocations = numAllocations - before;
+
+        if (transformResult != 0 || restoreResult != 0) {
+            cerr << argv[0] << " error: cannot compute BBWT of record " << i << endl;
+
+            return 1;
+        }
+
+        // In the second pass all buffers of the workspace are already large enough
+        // (only the interleaved decoding of long inputs uses temporary buffers)
+        if (k >= numRecords && transformAllocations > 0) {
+            cout << "\tBBWT of record " << i << " made " << transformAllocations << " heap allocation(s)" << endl;
+            result = 1;
+        }
+
+        if (k >= numRecords && len < MinInterleavedDecodeLength && restoreAllocations > 0) {
+            cout << "\tinverse BBWT of record " << i << " made " << restoreAllocations << " heap allocation(s)" << endl;
+            result = 1;
+        }
+
+        if (!equal(expected.begin(), expected.begin() + len, transformed.begin())) {
+            cout << "\tBBWT of record " << i << " differs" << endl;
+            result = 1;
+        }
+
+        if (!equal(record, record + len, restored.begin())) {
+            cout << "\trecord " << i << " is not restored correctly" << endl;
+            result = 1;
+        }
+    }
+
+    cout << "-- Finished --" << endl;
+
+    //-------------------------------------------------------------------------
+
+    return result;
+}
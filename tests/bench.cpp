@@ -0,0 +1,339 @@
+/**
+ * Benchmark of circular suffix array, BBWT and inverse BBWT computation.
+ * Each function is run repeatedly on synthetic inputs (random text, DNA, Fibonacci word, Thue-Morse word
+ * and a string with many Lyndon factors) and on the given corpus files. For each input and function
+ * the mean runtime, its standard deviation, throughput and the peak resident set size added by the function
+ * are printed as CSV.
+ *
+ * (c) 2023 Marcin Piątkowski, marcin.piatkowski(at)mat.umk.pl
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+
+#include <iostream>
+#include <iomanip>
+#include <cstdio>
+#include <cstdlib>
+#include <cmath>
+#include <chrono>
+#include <algorithm>
+#include <functional>
+#include <random>
+#include <string>
+#include <vector>
+
+#include <malloc.h>
+#include <sys/resource.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include "bbwt.hpp"
+#include "MappedFile.hpp"
+#include "bench_inputs.hpp"
+
+using namespace std;
+using Tnum = int;
+
+
+//-------------------------------------------------------------------------
+// Measurements
+//-------------------------------------------------------------------------
+
+struct Measurement {
+    double mean = 0;
+    double stddev = 0;
+    double min = 0;
+    long peakRss = 0;
+    bool ok = false;
+};
+
+
+/** Returns the value (in KiB) of the given field of /proc/self/status or -1 if it is not available. */
+long statusKiB(const string &field) {
+    FILE *status = fopen("/proc/self/status", "r");
+    char line[256];
+    long value = -1;
+
+    if (status == nullptr)
+        return -1;
+
+    while (fgets(line, sizeof(line), status) != nullptr) {
+        if (field.compare(0, string::npos, line, field.size()) == 0 && line[field.size()] == ':') {
+            value = atol(line + field.size() + 1);
+            break;
+        }
+    }
+
+    fclose(status);
+
+    return value;
+}
+
+
+/** Resets the peak resident set size of the process to its current value. @return true on success */
+bool resetPeakRss() {
+    FILE *clearRefs = fopen("/proc/self/clear_refs", "w");
+
+    if (clearRefs == nullptr)
+        return false;
+
+    bool reset = fputs("5", clearRefs) >= 0;
+
+    return fclose(clearRefs) == 0 && reset;
+}
+
+
+/** Runs task numRuns times in a child process. The child inherits the pages of the parent (the input data
+ * and earlier buffers) together with its peak resident set size, so the free memory of the allocator is released
+ * and the peak is reset right after the fork, and only the memory added on top of the resident set at that moment
+ * is reported. Where the peak cannot be reset the growth of ru_maxrss is reported, which misses memory below
+ * the inherited peak.
+ */
+Measurement measure(const function<int()> &task, int numRuns) {
+    Measurement result;
+    int fds[2];
+
+    if (pipe(fds) != 0)
+        return result;
+
+    pid_t pid = fork();
+
+    if (pid < 0)
+        return result;
+
+    if (pid == 0) {
+        struct rusage usage;
+
+        // Free memory kept by the allocator of the parent would be reused without being counted
+        malloc_trim(0);
+
+        bool peakReset = resetPeakRss();
+        long baseRss = peakReset ? statusKiB("VmRSS") : -1;
+
+        if (baseRss < 0) {
+            getrusage(RUSAGE_SELF, &usage);
+            baseRss = usage.ru_maxrss;
+            peakReset = false;
+        }
+
+        vector<double> times(numRuns);
+
+        close(fds[0]);
+
+        for (int r=0; r<numRuns; ++r) {
+            auto start = chrono::steady_clock::now();
+
+            if (task() != 0)
+                _exit(1);
+
+            times[r] = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+        }
+
+        long peakRss = peakReset ? statusKiB("VmHWM") : -1;
+
+        if (peakRss < 0) {
+            getrusage(RUSAGE_SELF, &usage);
+            peakRss = usage.ru_maxrss;
+        }
+
+        peakRss -= baseRss;
+
+        bool written = write(fds[1], times.data(), numRuns * sizeof(double)) == (ssize_t) (numRuns * sizeof(double))
+                       && write(fds[1], &peakRss, sizeof(peakRss)) == sizeof(peakRss);
+
+        _exit(written ? 0 : 1);
+    }
+
+    close(fds[1]);
+
+    vector<double> times(numRuns);
+    bool received = read(fds[0], times.data(), numRuns * sizeof(double)) == (ssize_t) (numRuns * sizeof(double))
+                    && read(fds[0], &result.peakRss, sizeof(result.peakRss)) == sizeof(result.peakRss);
+    int status;
+
+    close(fds[0]);
+    waitpid(pid, &status, 0);
+
+    if (!received || !WIFEXITED(status) || WEXITSTATUS(status) != 0)
+        return result;
+
+    result.min = *min_element(times.begin(), times.end());
+
+    for (double t : times)
+        result.mean += t / numRuns;
+
+    for (double t : times)
+        result.stddev += (t - result.mean) * (t - result.mean) / numRuns;
+
+    result.stddev = sqrt(result.stddev);
+    result.ok = true;
+
+    return result;
+}
+
+
+/** @return the value as a CSV field, quoted if it contains a separator, a quote or a line break */
+string csvField(const string &value) {
+    if (value.find_first_of(",\"\r\n") == string::npos)
+        return value;
+
+    string field = "\"";
+
+    for (char c : value) {
+        if (c == '"')
+            field += '"';
+        field += c;
+    }
+
+    return field + "\"";
+}
+
+
+/** Benchmarks all functions on the given input and prints one CSV row per function.
+ * @return 0 after successful computation, non-zero in case of any error
+ */
+int benchmark(const string &name, const unsigned char *inData, Tnum len, int numRuns, unsigned numThreads) {
+    vector<unsigned char> bbwtData(len);
+    vector<Tnum> csa(len);
+
+    // Inverse transform needs BBWT of the input, the buffers are released before measurements start
+    if (bbwt(inData, bbwtData.data(), csa.data(), len, 0, numThreads) != 0)
+        return -1;
+
+    vector<Tnum>().swap(csa);
+
+    const pair<const char *, function<int()>> tasks[] = {
+        {"circularSuffixArray", [&]() {
+            vector<Tnum> csa(len);
+
+            return circularSuffixArray(inData, csa.data(), len, 0, numThreads);
+        }},
+        {"bbwt", [&]() {
+            vector<unsigned char> outData(len);
+            vector<Tnum> csa(len);
+
+            return bbwt(inData, outData.data(), csa.data(), len, 0, numThreads);
+        }},
+        {"unbbwt", [&]() {
+            vector<unsigned char> outData(len);
+
+            return unbbwt(bbwtData.data(), outData.data(), len, 0, numThreads);
+        }}
+    };
+
+    int result = 0;
+
+    for (const auto &task : tasks) {
+        Measurement m = measure(task.second, numRuns);
+
+        if (!m.ok) {
+            cerr << "bench error: " << task.first << " failed for " << name << endl;
+            result = -1;
+
+            continue;
+        }
+
+        cout << csvField(name) << "," << len << "," << task.first << "," << numThreads << "," << numRuns << ","
+             << fixed << setprecision(6) << m.mean << "," << m.stddev << "," << m.min << ","
+             << setprecision(3) << ((m.mean > 0) ? len / m.mean / 1e6 : 0.0) << "," << m.peakRss << endl;
+    }
+
+    return result;
+}
+
+
+int main(int argc, char **argv) {
+    long sizeKiB = 8192;
+    int numRuns = 5;
+    unsigned numThreads = 1;
+    unsigned seed = 1;
+    int opt;
+
+    while ((opt = getopt(argc, argv, "n:r:t:s:")) != -1) {
+        switch (opt) {
+            case 'n':
+                sizeKiB = atol(optarg);
+                break;
+            case 'r':
+                numRuns = atoi(optarg);
+                break;
+            case 't':
+                numThreads = atoi(optarg);
+                break;
+            case 's':
+                seed = atoi(optarg);
+                break;
+            default:
+                argc = 0;
+        }
+    }
+
+    if (argc < optind || sizeKiB <= 0 || sizeKiB > (1L << 20) || numRuns <= 0) {
+        cerr << "Usage " << argv[0] << " [-n synthetic_size_KiB] [-r num_runs] [-t num_threads] [-s seed] [corpus_file...]" << endl;
+
+        return 1;
+    }
+
+    size_t len = sizeKiB * 1024;
+    mt19937 gen(seed);
+    int result = 0;
+
+    cout << "input,size,function,threads,runs,mean_s,stddev_s,min_s,mb_per_s,peak_rss_kib" << endl;
+
+    //-------------------------------------------------------------------------
+    // Synthetic inputs (generated from the given seed, so they are reproducible)
+    //-------------------------------------------------------------------------
+
+    // Inputs are generated one at a time, so that only the current one contributes to the peak memory usage
+    const pair<const char *, function<vector<unsigned char>()>> generators[] = {
+        {"random", [&]() { return randomText(len, gen); }},
+        {"dna", [&]() { return randomDna(len, gen); }},
+        {"fibonacci", [&]() { return fibonacciWord(len); }},
+        {"thue-morse", [&]() { return thueMorseWord(len); }},
+        {"lyndon-factors", [&]() { return manyLyndonFactors(len, gen); }}
+    };
+
+    for (const auto &generator : generators) {
+        vector<unsigned char> inData = generator.second();
+
+        if (benchmark(generator.first, inData.data(), len, numRuns, numThreads) != 0)
+            result = 1;
+    }
+
+    //-------------------------------------------------------------------------
+    // Corpus files
+    //-------------------------------------------------------------------------
+
+    for (int i=optind; i<argc; ++i) {
+        MappedFile inFile;
+
+        if (!inFile.openRead(argv[i]) || inFile.size() == 0 || inFile.size() > MaxIntLength) {
+            cerr << argv[0] << " error: cannot read input file " << argv[i] << endl;
+            result = 1;
+
+            continue;
+        }
+
+        if (benchmark(argv[i], inFile.data(), inFile.size(), numRuns, numThreads) != 0)
+            result = 1;
+    }
+
+    return result;
+}
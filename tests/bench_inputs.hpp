@@ -0,0 +1,115 @@
+#ifndef _BENCH_INPUTS_HPP_
+#define _BENCH_INPUTS_HPP_
+
+/*
+ * Synthetic inputs of the benchmarks.
+ *
+ * (c) 2023 Marcin Piątkowski, marcin.piatkowski(at)mat.umk.pl
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include <algorithm>
+#include <functional>
+#include <random>
+#include <vector>
+
+#include "lyndon.hpp"
+
+
+/** Uniformly random bytes. */
+std::vector<unsigned char> randomText(size_t len, std::mt19937 &gen) {
+    std::vector<unsigned char> text(len);
+
+    for (auto &c : text)
+        c = gen() & 255;
+
+    return text;
+}
+
+
+/** Uniformly random nucleotides. */
+std::vector<unsigned char> randomDna(size_t len, std::mt19937 &gen) {
+    std::vector<unsigned char> text(len);
+
+    for (auto &c : text)
+        c = "ACGT"[gen() & 3];
+
+    return text;
+}
+
+
+/** The prefix of the infinite Fibonacci word (f1 = b, f2 = a, fk = f(k-1)f(k-2)). */
+std::vector<unsigned char> fibonacciWord(size_t len) {
+    std::vector<unsigned char> prev(1, 'b'), text(1, 'a');
+
+    while (text.size() < len) {
+        std::vector<unsigned char> next(text);
+
+        next.insert(next.end(), prev.begin(), prev.end());
+        prev.swap(text);
+        text.swap(next);
+    }
+
+    text.resize(len);
+
+    return text;
+}
+
+
+/** The prefix of the Thue-Morse word. */
+std::vector<unsigned char> thueMorseWord(size_t len) {
+    std::vector<unsigned char> text(len);
+
+    for (size_t i=0; i<len; ++i)
+        text[i] = 'a' + (__builtin_popcountl(i) & 1);
+
+    return text;
+}
+
+
+/** Minimal rotations of short random words concatenated in non-increasing order, i.e. a string with many Lyndon factors. */
+std::vector<unsigned char> manyLyndonFactors(size_t len, std::mt19937 &gen) {
+    std::vector<std::vector<unsigned char>> words;
+
+    for (size_t total = 0; total < len; ) {
+        std::vector<unsigned char> word(1 + gen() % 16);
+
+        for (auto &c : word)
+            c = 'a' + gen() % 26;
+
+        std::rotate(word.begin(), word.begin() + minimalRotation(word.data(), (long) word.size()), word.end());
+        total += word.size();
+        words.push_back(word);
+    }
+
+    std::sort(words.begin(), words.end(), std::greater<std::vector<unsigned char>>());
+
+    std::vector<unsigned char> text;
+
+    for (const auto &word : words)
+        text.insert(text.end(), word.begin(), word.end());
+
+    text.resize(len);
+
+    return text;
+}
+
+
+#endif //_BENCH_INPUTS_HPP_
@@ -0,0 +1,246 @@
+/**
+ * Extended BWT testing.
+ * Input data is read from a file and each line is treated as a separate string of the collection.
+ * The eBWT of the collection is computed, then the collection is restored with the inverse of eBWT.
+ * The restored strings have to be Lyndon words and their eBWT has to be the same as the eBWT of the input.
+ *
+ * (c) 2023 Marcin Piątkowski, marcin.piatkowski(at)mat.umk.pl
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+
+#include <iostream>
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <random>
+#include <vector>
+
+#include "bbwt.hpp"
+#include "MappedFile.hpp"
+
+using namespace std;
+
+
+/** The number of random collections compared with the naive eBWT. */
+const int NumRandomCollections = 2000;
+
+
+/** Checks that eBWT of the input mapped to symbols of type Tsym is the mapped eBWT of the input.
+ * @return 0 if the result is correct, 1 otherwise
+ */
+template<typename Tsym, typename Tmap>
+int testWideSymbols(const char *name, const unsigned char *inData, const vector<int> &lengths,
+                    const vector<unsigned char> &transformed, Tmap map) {
+    const int dataSize = transformed.size();
+    vector<Tsym> mapped(dataSize), mappedTransformed(dataSize);
+    vector<int> csa(dataSize);
+
+    transform(inData, inData + dataSize, mapped.begin(), map);
+
+    if (ebwt(mapped.data(), lengths.data(), (int) lengths.size(), mappedTransformed.data(), csa.data()) != 0
+        || !equal(transformed.begin(), transformed.end(), mappedTransformed.begin(), [&](unsigned char c, Tsym s) { return map(c) == s; })) {
+        cout << "\teBWT of " << name << " symbols differs" << endl;
+
+        return 1;
+    }
+
+    return 0;
+}
+
+
+/** eBWT computed by sorting all rotations of all strings in the omega-order (i.e. as infinite periodic strings). */
+vector<unsigned char> naiveEbwt(const vector<unsigned char> &data, const vector<int> &lengths) {
+    struct Rotation {
+        int start, length, shift;
+    };
+
+    vector<Rotation> rotations;
+
+    for (int i=0, start=0; i<(int) lengths.size(); start+=lengths[i], ++i) {
+        for (int shift=0; shift<lengths[i]; ++shift)
+            rotations.push_back({start, lengths[i], shift});
+    }
+
+    auto charAt = [&](const Rotation &r, int i) {
+        return data[r.start + (r.shift + i) % r.length];
+    };
+
+    // Infinite periodic strings with periods p and q are equal if they agree on the first p + q characters
+    stable_sort(rotations.begin(), rotations.end(), [&](const Rotation &a, const Rotation &b) {
+        for (int i=0; i<a.length+b.length; ++i) {
+            if (charAt(a, i) != charAt(b, i))
+                return charAt(a, i) < charAt(b, i);
+        }
+
+        return false;
+    });
+
+    vector<unsigned char> result;
+
+    for (const Rotation &r : rotations)
+        result.push_back(charAt(r, r.length - 1));
+
+    return result;
+}
+
+
+/** Compares eBWT of small random collections (with many repeated and periodic strings) with naiveEbwt().
+ * @return 0 if all results are correct, 1 otherwise
+ */
+int testRandomCollections(int numTests) {
+    mt19937 gen(12345);
+
+    for (int t=0; t<numTests; ++t) {
+        int numStrings = 1 + gen() % 8;
+        int maxLength = 1 + gen() % 12;
+        int alphSize = 1 + gen() % 4;
+        vector<int> lengths(numStrings);
+        vector<unsigned char> data;
+
+        for (int &length : lengths) {
+            length = gen() % (maxLength + 1);
+
+            for (int i=0; i<length; ++i)
+                data.push_back('a' + gen() % alphSize);
+        }
+
+        vector<unsigned char> transformed(data.size());
+        vector<int> csa(data.size());
+
+        if (data.empty())
+            continue;
+
+        if (ebwt(data.data(), lengths.data(), numStrings, transformed.data(), csa.data()) != 0
+            || transformed != naiveEbwt(data, lengths)) {
+            cout << "\teBWT of the random collection " << t << " differs from the naive one" << endl;
+
+            return 1;
+        }
+    }
+
+    return 0;
+}
+
+
+int main(int argc, char **argv) {
+    MappedFile inFile;
+
+    if(argc != 2) {
+        cerr << "Usage " << argv[0] << " input_file" << endl;
+
+        return 1;
+    }
+
+    if (!inFile.openRead(argv[1])) {
+        cerr << argv[0] << " error: cannot read input file " << argv[1] << endl;
+
+        return 1;
+    }
+
+    const unsigned char *inData = inFile.data();
+    int dataSize = inFile.size();
+
+    //-------------------------------------------------------------------------
+    // Split the input into lines (line separators are kept at the end of lines)
+    //-------------------------------------------------------------------------
+
+    vector<int> lengths;
+
+    for (int start=0, pos=0; pos<dataSize; ++pos) {
+        if (inData[pos] == '\n' || pos == dataSize - 1) {
+            lengths.push_back(pos + 1 - start);
+            start = pos + 1;
+        }
+    }
+
+    cout << "-- Input size = " << dataSize << " B, " << lengths.size() << " string(s) --" << endl;
+
+    if (dataSize == 0) {
+        cout << "-- Finished --" << endl;
+
+        return 0;
+    }
+
+    //-------------------------------------------------------------------------
+    // Compute eBWT and its inverse
+    //-------------------------------------------------------------------------
+
+    vector<unsigned char> transformed(dataSize);
+    vector<unsigned char> restored(dataSize);
+    vector<unsigned char> retransformed(dataSize);
+    vector<int> csa(dataSize);
+    vector<int> restoredLengths(dataSize);
+    int numRestored = 0;
+    int result = 0;
+
+    if (ebwt(inData, lengths.data(), (int) lengths.size(), transformed.data(), csa.data()) != 0
+        || unebwt(transformed.data(), restored.data(), restoredLengths.data(), &numRestored, dataSize) != 0) {
+        cerr << argv[0] << " error: cannot compute eBWT" << endl;
+
+        return 1;
+    }
+
+    cout << "-- Restored " << numRestored << " primitive string(s) --" << endl;
+
+    //-------------------------------------------------------------------------
+    // Each restored string has to be a Lyndon word
+    //-------------------------------------------------------------------------
+
+    for (int i=0, start=0; i<numRestored; start+=restoredLengths[i], ++i) {
+        if (lyndonFactors(restored.data() + start, restoredLengths[i]) != 1) {
+            cout << "\tstring " << i << " is not a Lyndon word" << endl;
+            result = 1;
+        }
+    }
+
+    //-------------------------------------------------------------------------
+    // The restored collection has to have the same eBWT
+    //-------------------------------------------------------------------------
+
+    if (ebwt(restored.data(), restoredLengths.data(), numRestored, retransformed.data(), csa.data()) != 0
+        || retransformed != transformed) {
+        cout << "\teBWT of the restored collection differs" << endl;
+        result = 1;
+    }
+
+    //-------------------------------------------------------------------------
+    // Small random collections against the definition
+    //-------------------------------------------------------------------------
+
+    result |= testRandomCollections(NumRandomCollections);
+
+    //-------------------------------------------------------------------------
+    // Wide and negative symbols are mapped to the effective alphabet
+    //-------------------------------------------------------------------------
+
+    result |= testWideSymbols<uint32_t>("32-bit", inData, lengths, transformed,
+                                        [](unsigned char c) { return (uint32_t) (c * 16777259U + 7); });
+
+    result |= testWideSymbols<int32_t>("signed", inData, lengths, transformed,
+                                       [](unsigned char c) { return (int32_t) c - 128; });
+
+    cout << "-- Finished --" << endl;
+
+    //-------------------------------------------------------------------------
+
+    return result;
+}
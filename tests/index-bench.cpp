@@ -0,0 +1,186 @@
+/**
+ * Benchmark of pattern search with BbwtIndex.
+ * The index is built over synthetic inputs (random text, DNA, Fibonacci word, Thue-Morse word and a string with
+ * many Lyndon factors) and over the given corpus files. Patterns of several lengths are taken from random positions
+ * of each input, and for every input, query type and pattern length the query throughput is printed as CSV.
+ *
+ * (c) 2023 Marcin Piątkowski, marcin.piatkowski(at)mat.umk.pl
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include <iostream>
+#include <iomanip>
+#include <cstdlib>
+#include <climits>
+#include <chrono>
+#include <random>
+#include <string>
+#include <vector>
+
+#include <unistd.h>
+
+#include "bbwt.hpp"
+#include "bbwt_index.hpp"
+#include "MappedFile.hpp"
+#include "bench_inputs.hpp"
+
+using namespace std;
+using Tnum = int;
+
+
+/** Locate queries of a single pattern length stop after reporting this many occurrences in total. */
+const long MaxLocatedOccurrences = 10000000;
+
+
+/** Builds the index of the given input and prints one CSV row per query type and pattern length.
+ * @return 0 after successful computation, non-zero in case of any error
+ */
+int benchmark(const string &name, const unsigned char *inData, Tnum len, int numQueries, Tnum sampleRate, mt19937 &gen) {
+    vector<unsigned char> bbwtData(len);
+    vector<Tnum> csa(len);
+
+    if (bbwt(inData, bbwtData.data(), csa.data(), len) != 0)
+        return -1;
+
+    auto start = chrono::steady_clock::now();
+
+    BbwtIndex<unsigned char, Tnum> index(inData, bbwtData.data(), csa.data(), len, sampleRate);
+
+    double buildTime = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+
+    vector<Tnum>().swap(csa);
+
+    for (Tnum m : {4, 16, 64}) {
+        if (m > len)
+            continue;
+
+        vector<Tnum> patterns(numQueries);
+
+        for (auto &pos : patterns)
+            pos = gen() % (len - m + 1);
+
+        for (const char *query : {"count", "locate"}) {
+            bool locate = (query[0] == 'l');
+            vector<Tnum> positions;
+            long occurrences = 0;
+            int executed = 0;
+
+            start = chrono::steady_clock::now();
+
+            for (; executed < numQueries && (!locate || occurrences < MaxLocatedOccurrences); ++executed) {
+                if (locate) {
+                    positions.clear();
+                    occurrences += index.locate(inData + patterns[executed], m, positions);
+                }
+                else {
+                    occurrences += index.count(inData + patterns[executed], m);
+                }
+            }
+
+            double time = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+
+            cout << name << "," << len << "," << index.memoryUsage() << "," << fixed << setprecision(3) << buildTime << ","
+                 << query << "," << m << "," << executed << "," << occurrences << "," << setprecision(6) << time << ","
+                 << setprecision(0) << ((time > 0) ? executed / time : 0.0) << ","
+                 << setprecision(3) << ((executed > 0) ? time * 1e6 / executed : 0.0) << endl;
+        }
+    }
+
+    return 0;
+}
+
+
+int main(int argc, char **argv) {
+    long sizeKiB = 8192;
+    int numQueries = 100000;
+    Tnum sampleRate = 32;
+    unsigned seed = 1;
+    int opt;
+
+    while ((opt = getopt(argc, argv, "n:q:l:s:")) != -1) {
+        switch (opt) {
+            case 'n':
+                sizeKiB = atol(optarg);
+                break;
+            case 'q':
+                numQueries = atoi(optarg);
+                break;
+            case 'l':
+                sampleRate = atoi(optarg);
+                break;
+            case 's':
+                seed = atoi(optarg);
+                break;
+            default:
+                argc = 0;
+        }
+    }
+
+    if (argc < optind || sizeKiB <= 0 || sizeKiB > (1L << 20) || numQueries <= 0 || sampleRate <= 0) {
+        cerr << "Usage " << argv[0] << " [-n synthetic_size_KiB] [-q num_queries] [-l sample_rate] [-s seed] [corpus_file...]" << endl;
+
+        return 1;
+    }
+
+    size_t len = sizeKiB * 1024;
+    mt19937 gen(seed);
+    int result = 0;
+
+    cout << "input,size,index_bytes,build_s,query,pattern_length,queries,occurrences,total_s,queries_per_s,us_per_query" << endl;
+
+    //-------------------------------------------------------------------------
+    // Synthetic inputs (generated from the given seed, so they are reproducible)
+    //-------------------------------------------------------------------------
+
+    const pair<const char *, function<vector<unsigned char>()>> generators[] = {
+        {"random", [&]() { return randomText(len, gen); }},
+        {"dna", [&]() { return randomDna(len, gen); }},
+        {"fibonacci", [&]() { return fibonacciWord(len); }},
+        {"thue-morse", [&]() { return thueMorseWord(len); }},
+        {"lyndon-factors", [&]() { return manyLyndonFactors(len, gen); }}
+    };
+
+    for (const auto &generator : generators) {
+        vector<unsigned char> inData = generator.second();
+
+        if (benchmark(generator.first, inData.data(), len, numQueries, sampleRate, gen) != 0)
+            result = 1;
+    }
+
+    //-------------------------------------------------------------------------
+    // Corpus files
+    //-------------------------------------------------------------------------
+
+    for (int i=optind; i<argc; ++i) {
+        MappedFile inFile;
+
+        if (!inFile.openRead(argv[i]) || inFile.size() == 0 || inFile.size() >= (size_t) INT_MAX) {
+            cerr << argv[0] << " error: cannot read input file " << argv[i] << endl;
+            result = 1;
+
+            continue;
+        }
+
+        if (benchmark(argv[i], inFile.data(), inFile.size(), numQueries, sampleRate, gen) != 0)
+            result = 1;
+    }
+
+    return result;
+}
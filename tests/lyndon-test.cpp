@@ -0,0 +1,127 @@
+/**
+ * Lyndon factorisation testing.
+ * Input data is read from a file, then its Lyndon factorisation is computed
+ * with a single thread and with multiple threads and both results are compared.
+ *
+ * (c) 2023 Marcin Piątkowski, marcin.piatkowski(at)mat.umk.pl
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include <iostream>
+#include <cstdio>
+#include <new>
+
+#include "lyndon.hpp"
+
+using namespace std;
+using Tnum = int;
+
+
+/** Returns the number of positions at which both bit vectors differ. */
+Tnum compareBits(const BitVector<Tnum> &a, const BitVector<Tnum> &b) {
+    Tnum diff = 0;
+
+    for (Tnum pos=0; pos < a.size(); ++pos) {
+        if (a.get(pos) != b.get(pos))
+            ++diff;
+    }
+
+    return diff;
+}
+
+
+int main(int argc, char **argv) {
+    unsigned char *inData = nullptr;
+    FILE *inFile;
+
+    if(argc != 2) {
+        cerr << "Usage " << argv[0] << " input_file" << endl;
+
+        return 1;
+    }
+
+    //-------------------------------------------------------------------------
+    // Read data from the input file
+    //-------------------------------------------------------------------------
+
+    if ((inFile = fopen(argv[1], "rb")) == nullptr) {
+        cerr << argv[0] << " error: cannot open input file " << argv[1] << endl;
+
+        return 1;
+    }
+
+    fseek(inFile, 0, SEEK_END);
+    Tnum dataSize = ftell(inFile);
+    rewind(inFile);
+
+    cout << "-- Input size = " << dataSize << " B --" << endl;
+
+    try {
+        inData = new unsigned char[dataSize];
+    }
+    catch (const bad_alloc &e) {
+        cerr << argv[0] << ": Memory allocation error" << endl;
+
+        return 2;
+    }
+
+    Tnum dataCount = fread((char*) inData, sizeof(char), dataSize, inFile);
+    fclose(inFile);
+
+    if (dataCount != dataSize) {
+        cerr << argv[0] << " error: input data read partially" << endl;
+
+        return 1;
+    }
+
+    //-------------------------------------------------------------------------
+    // Compare single-threaded and multi-threaded factorisations
+    //-------------------------------------------------------------------------
+
+    BitVector<Tnum> factors(dataSize + 1), unique(dataSize + 1);
+    Tnum numFactors = lyndonFactorsRange(inData, 0, dataSize, &factors, &unique);
+    factors.set(dataSize, true);
+
+    cout << "-- Lyndon factors = " << numFactors << " --" << endl;
+
+    int result = 0;
+
+    for (unsigned numThreads : {2U, 3U, 8U, 61U}) {
+        BitVector<Tnum> parFactors(dataSize + 1), parUnique(dataSize + 1);
+        Tnum parNumFactors = lyndonFactorsParallel(inData, dataSize, &parFactors, &parUnique, numThreads);
+
+        Tnum diffFactors = compareBits(factors, parFactors);
+        Tnum diffUnique = compareBits(unique, parUnique);
+
+        if (parNumFactors != numFactors || diffFactors != 0 || diffUnique != 0) {
+            cout << "\t" << numThreads << " threads: " << parNumFactors << " factors, "
+                 << diffFactors << " factor and " << diffUnique << " unique differences" << endl;
+            result = 1;
+        }
+    }
+
+    cout << "-- Finished --" << endl;
+
+    delete[] inData;
+
+    //-------------------------------------------------------------------------
+
+    return result;
+}